@@ -0,0 +1,18 @@
+#version 330
+
+uniform mat4 matrix;
+uniform float tile_size;
+
+layout(location = 0) in ivec2 position;
+
+out vec2 frag_texcoord0;
+
+void main()
+{
+	vec2 corner = vec2(gl_VertexID / 2, gl_VertexID % 2);
+
+	// Shadow is twice the size of tile, centered on it, and just below it
+	gl_Position = matrix * vec4(vec2(position) + (((corner * 2.0) - 0.5) * tile_size), -1.0, 1.0);
+
+	frag_texcoord0 = corner;
+}
@@ -0,0 +1,31 @@
+#version 330
+
+uniform mat4 matrix;
+uniform float tile_size;
+uniform float texture_size;
+
+layout(location = 0) in ivec2 position;
+layout(location = 1) in uvec2 cell;
+layout(location = 2) in uvec2 look;
+
+out vec2 frag_texcoord0;
+out vec2 frag_texcoord1;
+
+const vec2 unit_corners[4] = vec2[4](vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0));
+const int strip_corners[4] = int[4](0, 1, 3, 2);
+
+void main()
+{
+	vec2 corner = vec2(gl_VertexID / 2, gl_VertexID % 2);
+	int rotation = int(look.x);
+	int bevel = int(look.y);
+
+	gl_Position = matrix * vec4(vec2(position) + (corner * tile_size), 0.0, 1.0);
+
+	// Rotate texture corners instead of quad
+	frag_texcoord0 = (vec2(cell) + unit_corners[(strip_corners[gl_VertexID] + rotation) % 4]) * texture_size;
+
+	// Bevels are stored unrotated, and each rotation moves one column left in bumpmap
+	vec2 bevel_pos = vec2(((bevel % 4) - rotation + 4) % 4, bevel / 4);
+	frag_texcoord1 = (bevel_pos * 0.25) + 0.0625 + (corner * 0.125);
+}
@@ -30,6 +30,7 @@
 #include <QPainter>
 #include <QPixmap>
 #include <QSettings>
+#include <QSpinBox>
 
 //-----------------------------------------------------------------------------
 
@@ -73,6 +74,10 @@ AppearanceDialog::AppearanceDialog(QWidget* parent)
 	m_has_shadows = new QCheckBox(tr("Drop shadows"), options_group);
 	connect(m_has_shadows, &QCheckBox::stateChanged, this, &AppearanceDialog::updatePreview);
 
+	m_detail_size = new QSpinBox(options_group);
+	m_detail_size->setRange(0, 64);
+	m_detail_size->setSuffix(tr(" pixels"));
+
 	// Create colors widgets
 	QGroupBox* colors_group = new QGroupBox(tr("Colors"), this);
 
@@ -101,6 +106,11 @@ AppearanceDialog::AppearanceDialog(QWidget* parent)
 	options_layout->addWidget(m_has_bevels);
 	options_layout->addWidget(m_has_shadows);
 
+	QFormLayout* detail_layout = new QFormLayout;
+	detail_layout->setContentsMargins(0, 0, 0, 0);
+	detail_layout->addRow(tr("Simplify tiles smaller than:"), m_detail_size);
+	options_layout->addLayout(detail_layout);
+
 	QGridLayout* layout = new QGridLayout(this);
 	layout->setSpacing(12);
 	layout->setColumnStretch(1, 1);
@@ -118,6 +128,7 @@ AppearanceDialog::AppearanceDialog(QWidget* parent)
 	m_highlight->setColor(settings.value("Colors/Highlight", QColor(Qt::white)).value<QColor>());
 	m_has_bevels->setChecked(settings.value("Appearance/Bevels", true).toBool());
 	m_has_shadows->setChecked(settings.value("Appearance/Shadows", true).toBool());
+	m_detail_size->setValue(settings.value("Appearance/DetailSize", 8).toInt());
 	if (!m_bevels_enabled) {
 		m_has_bevels->setChecked(false);
 		m_has_bevels->setEnabled(false);
@@ -141,6 +152,13 @@ bool AppearanceDialog::hasShadows() const
 
 //-----------------------------------------------------------------------------
 
+int AppearanceDialog::detailSize() const
+{
+	return m_detail_size->value();
+}
+
+//-----------------------------------------------------------------------------
+
 QPalette AppearanceDialog::colors() const
 {
 	QPalette palette;
@@ -167,6 +185,7 @@ void AppearanceDialog::accept()
 	settings.setValue("Colors/Highlight", m_highlight->color().name());
 	settings.setValue("Appearance/Bevels", m_has_bevels->isChecked());
 	settings.setValue("Appearance/Shadows", m_has_shadows->isChecked());
+	settings.setValue("Appearance/DetailSize", m_detail_size->value());
 	QDialog::accept();
 }
 
@@ -179,6 +198,7 @@ void AppearanceDialog::restoreDefaults()
 	m_highlight->setColor(Qt::white);
 	m_has_bevels->setChecked(true);
 	m_has_shadows->setChecked(true);
+	m_detail_size->setValue(8);
 	updatePreview();
 }
 
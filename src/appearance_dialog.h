@@ -24,6 +24,7 @@
 class QAbstractButton;
 class QCheckBox;
 class QLabel;
+class QSpinBox;
 class ColorButton;
 
 class AppearanceDialog : public QDialog
@@ -34,6 +35,7 @@ public:
 
 	bool hasBevels() const;
 	bool hasShadows() const;
+	int detailSize() const;
 	QPalette colors() const;
 
 	static void setBevelsEnabled(bool enabled);
@@ -48,6 +50,7 @@ private slots:
 private:
 	QCheckBox* m_has_bevels;
 	QCheckBox* m_has_shadows;
+	QSpinBox* m_detail_size;
 	ColorButton* m_background;
 	ColorButton* m_shadow;
 	ColorButton* m_highlight;
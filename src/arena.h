@@ -0,0 +1,137 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <QVector>
+
+#include <new>
+#include <utility>
+
+// Allocates objects of one type from large blocks that are released together
+template<typename T>
+class Arena
+{
+public:
+	explicit Arena(int block_size = 1024);
+	~Arena();
+
+	template<typename... Args> T* create(Args&&... args);
+	void destroy(T* object);
+	void reserve(int count);
+	void clear();
+
+private:
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void addBlock(int capacity);
+
+private:
+	struct Block
+	{
+		void* data;
+		int count;
+		int capacity;
+	};
+	QVector<Block> m_blocks;
+	int m_block_size;
+};
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+Arena<T>::Arena(int block_size) :
+	m_block_size(block_size)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+Arena<T>::~Arena()
+{
+	clear();
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+template<typename... Args>
+T* Arena<T>::create(Args&&... args)
+{
+	if (m_blocks.isEmpty() || (m_blocks.last().count == m_blocks.last().capacity)) {
+		addBlock(m_block_size);
+	}
+	Block& block = m_blocks.last();
+	void* address = static_cast<char*>(block.data) + (block.count * sizeof(T));
+	++block.count;
+	return new (address) T(std::forward<Args>(args)...);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+void Arena<T>::destroy(T* object)
+{
+	// Memory is not reused until the whole arena is cleared
+	if (object) {
+		object->~T();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+void Arena<T>::reserve(int count)
+{
+	int available = 0;
+	if (!m_blocks.isEmpty()) {
+		available = m_blocks.last().capacity - m_blocks.last().count;
+	}
+	if (count > available) {
+		addBlock(count);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+void Arena<T>::clear()
+{
+	// Objects are not destroyed here; those with destructors that matter must be destroyed first
+	for (const Block& block : m_blocks) {
+		::operator delete(block.data);
+	}
+	m_blocks.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+void Arena<T>::addBlock(int capacity)
+{
+	Block block = { ::operator new(capacity * sizeof(T)), 0, capacity };
+	m_blocks.append(block);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif
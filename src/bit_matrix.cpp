@@ -0,0 +1,367 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "bit_matrix.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+
+static inline unsigned int countTrailingZeros(quint64 value)
+{
+	Q_ASSERT(value != 0);
+#if defined(Q_CC_GNU) || defined(Q_CC_CLANG)
+	return __builtin_ctzll(value);
+#else
+	unsigned int count = 0;
+	while (!(value & 1)) {
+		value >>= 1;
+		++count;
+	}
+	return count;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+static bool isConnected(const quint32* cells, quint32 count, unsigned int width)
+{
+	// Only check rows small enough to track with a single mask
+	if (count < 2 || count > 64) {
+		return false;
+	}
+
+	// Flood fill from first cell
+	quint64 reached = 1;
+	quint64 pending = 1;
+	while (pending) {
+		const quint32 index = countTrailingZeros(pending);
+		pending &= pending - 1;
+		const quint32 cell = cells[index];
+		for (quint32 i = 0; i < count; ++i) {
+			const quint64 bit = Q_UINT64_C(1) << i;
+			if (reached & bit) {
+				continue;
+			}
+			const quint32 other = cells[i];
+			const quint32 low = std::min(cell, other);
+			const quint32 distance = std::max(cell, other) - low;
+			if ((distance == width) || (distance == 1 && (low % width) != (width - 1))) {
+				reached |= bit;
+				pending |= bit;
+			}
+		}
+	}
+	return reached == ((count < 64) ? ((Q_UINT64_C(1) << count) - 1) : ~Q_UINT64_C(0));
+}
+
+//-----------------------------------------------------------------------------
+
+DLX::BitMatrix::BitMatrix(unsigned int width, unsigned int max_columns, unsigned int max_elements) :
+	m_width(width),
+	m_max_columns(max_columns),
+	m_grid_rows((max_columns + width - 1) / width),
+	m_full((width < 64) ? ((Q_UINT64_C(1) << width) - 1) : ~Q_UINT64_C(0)),
+	m_prepared(false),
+	m_prune(false),
+	m_occupied(m_grid_rows, 0),
+	m_stack(max_columns),
+	m_cancelled(nullptr),
+	m_solutions(0),
+	m_tries(0)
+{
+	Q_ASSERT(width > 0 && width <= 64);
+	m_elements.reserve(max_elements);
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::addRow()
+{
+	m_row_starts.append(m_elements.count());
+	m_prepared = false;
+	++m_statistics.rows;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::addElement(unsigned int column)
+{
+	Q_ASSERT(column < m_max_columns);
+	Q_ASSERT(!m_row_starts.isEmpty());
+
+	m_elements.append(column);
+	m_prepared = false;
+	++m_statistics.nodes;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::setCancelled(const QAtomicInt* cancelled)
+{
+	m_cancelled = cancelled;
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int DLX::BitMatrix::search(Callback* solution, unsigned int max_solutions, unsigned int max_tries)
+{
+	m_solution = solution;
+
+	m_solutions = 0;
+	m_max_solutions = max_solutions;
+
+	m_tries = 0;
+	m_max_tries = (max_tries != 0) ? max_tries : m_max_columns;
+
+	if (!m_prepared) {
+		prepare();
+	}
+	solve();
+	m_statistics.tries += m_tries;
+	m_statistics.max_tries += m_max_tries;
+	m_statistics.solutions += m_solutions;
+	return m_solutions;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::prepare()
+{
+	const quint32 rows = m_row_starts.count();
+	const quint32 elements = m_elements.count();
+
+	m_first_row.resize(rows);
+	m_mask_starts.resize(rows + 1);
+	m_masks.clear();
+	m_masks.reserve(rows * 4);
+	m_candidate_starts.fill(0, m_max_columns + 1);
+	QVector<quint32> first_cells(rows);
+	m_prune = true;
+
+	for (quint32 row = 0; row < rows; ++row) {
+		const quint32 start = m_row_starts.at(row);
+		const quint32 end = (row + 1 < rows) ? m_row_starts.at(row + 1) : elements;
+
+		// Find cells covered by row
+		quint32 first = 0xFFFFFFFF;
+		quint32 last = 0;
+		for (quint32 i = start; i < end; ++i) {
+			first = std::min(first, m_elements.at(i));
+			last = std::max(last, m_elements.at(i));
+		}
+		first_cells[row] = first;
+		m_prune = m_prune && isConnected(m_elements.constData() + start, end - start, m_width);
+
+		// Convert cells to masks of grid rows
+		m_mask_starts[row] = m_masks.count();
+		if (start == end) {
+			m_first_row[row] = 0;
+			continue;
+		}
+		const quint32 first_row = first / m_width;
+		m_first_row[row] = first_row;
+		const int mask_start = m_masks.count();
+		for (quint32 i = first_row; i <= last / m_width; ++i) {
+			m_masks.append(0);
+		}
+		for (quint32 i = start; i < end; ++i) {
+			const quint32 cell = m_elements.at(i);
+			const quint32 grid_row = cell / m_width;
+			m_masks[mask_start + grid_row - first_row] |= Q_UINT64_C(1) << (cell - (grid_row * m_width));
+		}
+
+		m_candidate_starts[first + 1]++;
+	}
+	m_mask_starts[rows] = m_masks.count();
+
+	// Group rows by their first cell, keeping the order they were added in
+	for (quint32 i = 0; i < m_max_columns; ++i) {
+		m_candidate_starts[i + 1] += m_candidate_starts[i];
+	}
+	m_candidates.resize(m_candidate_starts.at(m_max_columns));
+	QVector<quint32> positions = m_candidate_starts;
+	for (quint32 row = 0; row < rows; ++row) {
+		const quint32 first = first_cells.at(row);
+		if (first != 0xFFFFFFFF) {
+			m_candidates[positions[first]++] = row;
+		}
+	}
+
+	// Cells past the last column are always filled
+	m_occupied.fill(0);
+	const quint32 extra = (m_grid_rows * m_width) - m_max_columns;
+	if (extra) {
+		m_occupied.last() = m_full & ~((Q_UINT64_C(1) << (m_width - extra)) - 1);
+	}
+
+	m_prepared = true;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::solve()
+{
+	const quint32* candidates = m_candidates.constData();
+	const quint32* candidate_starts = m_candidate_starts.constData();
+	const quint64* occupied = m_occupied.constData();
+	Frame* stack = m_stack.data();
+
+	unsigned int k = 0;
+	bool descend = true;
+	for (;;) {
+		if (descend) {
+			// Find first empty cell; every cell before the last one filled is full
+			quint32 grid_row = (k > 0) ? (stack[k - 1].cell / m_width) : 0;
+			while (grid_row < m_grid_rows && occupied[grid_row] == m_full) {
+				++grid_row;
+			}
+
+			// If grid is full a solution has been found.
+			if (grid_row == m_grid_rows) {
+				++m_solutions;
+				report(k);
+				if (m_solutions >= m_max_solutions) {
+					break;
+				}
+			} else if ((m_solutions >= m_max_solutions) || (++m_tries >= m_max_tries)) {
+				break;
+			} else if (m_cancelled && m_cancelled->loadAcquire()) {
+				break;
+			} else {
+				Frame& frame = stack[k];
+				frame.cell = (grid_row * m_width) + countTrailingZeros(~occupied[grid_row] & m_full);
+				frame.next = candidate_starts[frame.cell];
+				frame.row = 0xFFFFFFFF;
+				++k;
+			}
+		}
+
+		// Search is finished if there are no more rows to try
+		if (k == 0) {
+			break;
+		}
+
+		// Move to next row that fits at first empty cell of current depth
+		Frame& frame = stack[k - 1];
+		if (frame.row != 0xFFFFFFFF) {
+			toggle(frame.row);
+			frame.row = 0xFFFFFFFF;
+			++m_statistics.uncovers;
+		}
+		const quint32 end = candidate_starts[frame.cell + 1];
+		while (frame.next < end) {
+			const quint32 row = candidates[frame.next++];
+			if (fits(row)) {
+				toggle(row);
+				++m_statistics.covers;
+				if (m_prune && isolates(row)) {
+					toggle(row);
+					++m_statistics.uncovers;
+					continue;
+				}
+				frame.row = row;
+				break;
+			}
+		}
+
+		if (frame.row != 0xFFFFFFFF) {
+			descend = true;
+		} else {
+			--k;
+			descend = false;
+			++m_statistics.backtracks;
+		}
+	}
+
+	// Restore grid if search was stopped early
+	while (k > 0) {
+		const Frame& frame = stack[--k];
+		if (frame.row != 0xFFFFFFFF) {
+			toggle(frame.row);
+			++m_statistics.uncovers;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::report(unsigned int k)
+{
+	const quint32 elements = m_elements.count();
+	const quint32 rows = m_row_starts.count();
+
+	QVector<Row> solution(k);
+	for (unsigned int i = 0; i < k; ++i) {
+		const quint32 row = m_stack.at(i).row;
+		const quint32 end = (row + 1 < rows) ? m_row_starts.at(row + 1) : elements;
+		for (quint32 j = m_row_starts.at(row); j < end; ++j) {
+			solution[i].append(m_elements.at(j));
+		}
+	}
+
+	(*m_solution)(solution);
+}
+
+//-----------------------------------------------------------------------------
+
+bool DLX::BitMatrix::fits(quint32 row) const
+{
+	const quint64* occupied = m_occupied.constData() + m_first_row.at(row);
+	const quint64* masks = m_masks.constData();
+	const quint32 end = m_mask_starts.at(row + 1);
+	for (quint32 i = m_mask_starts.at(row); i < end; ++i, ++occupied) {
+		if (*occupied & masks[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::BitMatrix::toggle(quint32 row)
+{
+	quint64* occupied = m_occupied.data() + m_first_row.at(row);
+	const quint64* masks = m_masks.constData();
+	const quint32 end = m_mask_starts.at(row + 1);
+	for (quint32 i = m_mask_starts.at(row); i < end; ++i, ++occupied) {
+		*occupied ^= masks[i];
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool DLX::BitMatrix::isolates(quint32 row) const
+{
+	const quint64* occupied = m_occupied.constData();
+	const quint32 first = (m_first_row.at(row) > 0) ? (m_first_row.at(row) - 1) : 0;
+	const quint32 last = std::min(m_first_row.at(row) + (m_mask_starts.at(row + 1) - m_mask_starts.at(row)), m_grid_rows - 1);
+	for (quint32 i = first; i <= last; ++i) {
+		const quint64 empty = ~occupied[i] & m_full;
+		const quint64 above = (i > 0) ? (~occupied[i - 1] & m_full) : 0;
+		const quint64 below = (i + 1 < m_grid_rows) ? (~occupied[i + 1] & m_full) : 0;
+		if (empty & ~(above | below | (empty << 1) | (empty >> 1))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
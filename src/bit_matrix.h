@@ -0,0 +1,196 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TETZLE_BIT_MATRIX_H
+#define TETZLE_BIT_MATRIX_H
+
+#include "dancing_links.h"
+
+namespace DLX
+{
+
+/**
+ * Bitboard solver for exact cover problems on narrow grids.
+ *
+ * The columns are treated as the cells of a grid that is at most 64 cells
+ * wide, numbered row by row. Each grid row of the board is kept as a single
+ * 64-bit occupancy word, and each matrix row as the masks of the grid rows
+ * that it touches. The search always fills the first empty cell, so only
+ * the matrix rows that start at that cell need to be tested, and testing or
+ * placing a row is a handful of word-wide operations instead of walking
+ * linked lists.
+ *
+ * If every row is a connected shape of at least two cells, a row is also
+ * rejected when it leaves an empty cell that has no empty neighbors, since
+ * no other row could cover that cell.
+ *
+ * It has the same interface as Matrix, and calls the same callbacks.
+ */
+class BitMatrix
+{
+	/** Search state at one depth. */
+	struct Frame
+	{
+		quint32 cell; /**< first empty cell being filled at this depth */
+		quint32 next; /**< position of next candidate to try for @a cell */
+		quint32 row; /**< row placed at this depth, or 0xFFFFFFFF if none */
+	};
+
+public:
+	/**
+	 * Constructs a matrix with @p max_columns number of columns.
+	 *
+	 * @param width how many columns are in each row of the grid; at most 64
+	 * @param max_columns amount of constraints
+	 * @param max_elements expected amount of elements, used to reserve memory up front
+	 */
+	BitMatrix(unsigned int width, unsigned int max_columns, unsigned int max_elements = 0);
+
+	/** Add row to matrix. */
+	void addRow();
+
+	/**
+	 * Add element to matrix.
+	 *
+	 * @param column which column in current row to mark as filled
+	 */
+	void addElement(unsigned int column);
+
+	/**
+	 * Set flag that stops search early when it becomes non-zero.
+	 *
+	 * @param cancelled flag to check before each attempt, or @c nullptr to never stop early
+	 */
+	void setCancelled(const QAtomicInt* cancelled);
+
+	/**
+	 * Returns the work done by matrix since it was constructed.
+	 *
+	 * Placing a row counts as a cover, and removing it again as an uncover.
+	 */
+	const Statistics& statistics() const
+	{
+		return m_statistics;
+	}
+
+	/**
+	 * Search for solutions.
+	 *
+	 * @param max_solutions maximum allowed solutions
+	 * @param max_tries maximum allowed attempts before stopping search
+	 * @return total count of solutions
+	 */
+	unsigned int search(unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
+	{
+		Callback solution;
+		return search(&solution, max_solutions, max_tries);
+	}
+
+	/**
+	 * Search for solutions.
+	 *
+	 * @param function non-member function called with each solution
+	 * @param max_solutions maximum allowed solutions before stopping search
+	 * @param max_tries maximum allowed attempts before stopping search
+	 * @return total count of solutions
+	 */
+	unsigned int search(void(*function)(const QVector<Row>& rows), unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
+	{
+		GlobalCallback solution(function);
+		return search(&solution, max_solutions, max_tries);
+	}
+
+	/**
+	 * Search for solutions.
+	 *
+	 * @param object pointer to object of callback
+	 * @param function member function of @p object called with each solution
+	 * @param max_solutions maximum allowed solutions before stopping search
+	 * @param max_tries maximum allowed attempts before stopping search
+	 * @return total count of solutions
+	 */
+	template <typename T>
+	unsigned int search(T* object, void(T::*function)(const QVector<Row>& rows), unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
+	{
+		MemberCallback<T> solution(object, function);
+		return search(&solution, max_solutions, max_tries);
+	}
+
+private:
+	/**
+	 * Performs the search for solutions.
+	 *
+	 * @param solution function called with each solution
+	 * @param max_solutions maximum allowed solutions before stopping search
+	 * @param max_tries maximum allowed attempts before stopping search
+	 * @return total count of solutions
+	 */
+	unsigned int search(Callback* solution, unsigned int max_solutions, unsigned int max_tries);
+
+	/** Convert rows into grid masks and group them by their first cell. */
+	void prepare();
+
+	/** Fill grid with search frames until it is full or no rows fit. */
+	void solve();
+
+	/** Pass the rows of the first @p k search frames to the solution callback. */
+	void report(unsigned int k);
+
+	/** Check if @p row does not overlap any filled cells. */
+	bool fits(quint32 row) const;
+
+	/** Fill or empty the cells of @p row. */
+	void toggle(quint32 row);
+
+	/** Check if an empty cell with no empty neighbors is next to the cells of @p row. */
+	bool isolates(quint32 row) const;
+
+private:
+	unsigned int m_width; /**< how many columns are in each row of the grid */
+	unsigned int m_max_columns; /**< amount of constraints */
+	unsigned int m_grid_rows; /**< how many rows are in the grid */
+	quint64 m_full; /**< occupancy of a completely filled grid row */
+
+	QVector<quint32> m_elements; /**< columns of all rows */
+	QVector<quint32> m_row_starts; /**< position of first element of each row */
+
+	QVector<quint32> m_first_row; /**< first grid row touched by each row */
+	QVector<quint32> m_mask_starts; /**< position of first grid mask of each row */
+	QVector<quint64> m_masks; /**< grid masks of all rows */
+	QVector<quint32> m_candidate_starts; /**< position of first candidate of each cell */
+	QVector<quint32> m_candidates; /**< rows grouped by their first cell */
+	bool m_prepared; /**< have rows been converted since last change */
+	bool m_prune; /**< are all rows connected shapes of at least two cells */
+
+	QVector<quint64> m_occupied; /**< filled cells of each grid row */
+	QVector<Frame> m_stack; /**< search frames; their rows do not conflict */
+
+	const QAtomicInt* m_cancelled; /**< flag to stop search early */
+	Callback* m_solution; /**< function to call when a solution is found */
+	unsigned int m_solutions; /**< how many solutions have been found so far */
+	unsigned int m_max_solutions; /**< maximum allowed solutions */
+	unsigned int m_tries; /**< how many attempts have been made so far */
+	unsigned int m_max_tries; /**< maximum allowed attempts */
+
+	Statistics m_statistics; /**< work done by matrix */
+};
+
+}
+
+#endif // TETZLE_BIT_MATRIX_H
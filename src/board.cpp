@@ -21,6 +21,7 @@
 
 #include "appearance_dialog.h"
 #include "generator.h"
+#include "layout_cache.h"
 #include "message.h"
 #include "overview.h"
 #include "path.h"
@@ -30,15 +31,19 @@
 
 #include <QApplication>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QMatrix4x4>
 #include <QMessageBox>
 #include <QMouseEvent>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLTexture>
 #include <QPainter>
 #include <QSettings>
+#include <QTimer>
 #include <QWheelEvent>
 #include <QVector2D>
 #include <QXmlStreamReader>
@@ -67,6 +72,89 @@ int powerOfTwo(int value)
 
 namespace
 {
+	// Most milliseconds spent settling pushed pieces before the board is drawn
+	const int settle_time = 10;
+
+	// Finds positions for rectangles of sizes in rows, leaving at least
+	// spacing between them, so that the rows are close to the ratio of aspect
+	QVector<QPoint> packShelves(const QVector<QSize>& sizes, int spacing, int jitter, qreal aspect, std::mt19937& random)
+	{
+		const int count = sizes.count();
+		QVector<QPoint> positions(count);
+		if (count == 0) {
+			return positions;
+		}
+
+		// Rectangles taller than a single piece go first, tallest first,
+		// so that they share rows instead of making every row tall
+		QVector<int> order(count);
+		for (int i = 0; i < count; ++i) {
+			order[i] = i;
+		}
+		auto large = [&sizes](int i) { return sizes.at(i).height() > Tile::size * 4; };
+		auto taller = [&sizes](int a, int b) { return sizes.at(a).height() > sizes.at(b).height(); };
+		auto rest = std::stable_partition(order.begin(), order.end(), large);
+		std::stable_sort(order.begin(), rest, taller);
+
+		// Choose random gaps up front so that every layout uses the same ones
+		QVector<int> gaps(count);
+		QVector<int> offsets(count);
+		std::uniform_int_distribution<int> gap(0, jitter);
+		std::uniform_int_distribution<int> offset(0, 0xFFFF);
+		qreal area = 0;
+		int widest = 0;
+		for (int i = 0; i < count; ++i) {
+			gaps[i] = gap(random);
+			offsets[i] = offset(random);
+			area += (sizes.at(i).width() + spacing + gaps.at(i)) * (sizes.at(i).height() + spacing);
+			widest = std::max(widest, sizes.at(i).width());
+		}
+
+		// Fill rows from left to right, and stack rows from top to bottom
+		QVector<int> shelf_tops;
+		QVector<int> shelf_heights;
+		QVector<int> shelves(count);
+		auto layout = [&](int width) {
+			shelf_heights.clear();
+			int x = 0;
+			for (int i : order) {
+				const QSize& size = sizes.at(i);
+				if (shelf_heights.isEmpty() || ((x > 0) && (x + size.width() > width))) {
+					shelf_heights.append(0);
+					x = 0;
+				}
+				positions[i].setX(x);
+				shelves[i] = shelf_heights.count() - 1;
+				shelf_heights.last() = std::max(shelf_heights.last(), size.height());
+				x += size.width() + spacing + gaps.at(i);
+			}
+
+			shelf_tops.resize(shelf_heights.count());
+			int y = 0;
+			for (int i = 0; i < shelf_heights.count(); ++i) {
+				shelf_tops[i] = y;
+				y += shelf_heights.at(i) + spacing;
+			}
+			return y;
+		};
+
+		// Rows waste space, so correct width once after seeing how tall the rows are
+		int width = std::max(widest, int(std::sqrt(area * aspect)));
+		int height = layout(width);
+		width = std::max(widest, int(width * std::sqrt((height * aspect) / width)));
+		height = layout(width);
+
+		// Move each rectangle to a random height inside of its row, and center them all on origin
+		const QPoint center(width / 2, height / 2);
+		for (int i = 0; i < count; ++i) {
+			const int shelf = shelves.at(i);
+			const int room = shelf_heights.at(shelf) - sizes.at(i).height();
+			positions[i].setY(shelf_tops.at(shelf) + (offsets.at(i) % (room + 1)));
+			positions[i] -= center;
+		}
+		return positions;
+	}
+
 	struct PieceDetails
 	{
 		QPoint pos;
@@ -88,8 +176,12 @@ Board::Board(QWidget* parent) :
 	m_load_bevels(true),
 	m_has_bevels(true),
 	m_has_shadows(true),
+	m_detail_size(0),
 	m_image(nullptr),
 	m_image_ts(0),
+	m_board_layer(nullptr),
+	m_board_layer_supported(false),
+	m_board_layer_changed(true),
 	m_columns(0),
 	m_rows(0),
 	m_total_pieces(0),
@@ -109,6 +201,11 @@ Board::Board(QWidget* parent) :
 
 	m_message = new Message(this);
 
+	// Settle pushed pieces a little each frame
+	m_settle_timer = new QTimer(this);
+	m_settle_timer->setInterval(0);
+	connect(m_settle_timer, &QTimer::timeout, this, &Board::settlePieces);
+
 	// Create overview dialog
 	m_overview = new Overview(parent);
 	connect(m_overview, &Overview::toggled, this, &Board::overviewToggled);
@@ -121,6 +218,7 @@ Board::~Board()
 	cleanup();
 	delete m_bumpmap_image;
 	delete m_shadow_image;
+	delete m_board_layer;
 	delete m_message;
 	delete graphics_layer;
 	graphics_layer = 0;
@@ -130,8 +228,8 @@ Board::~Board()
 
 Piece* Board::findCollidingPiece(Piece* piece) const
 {
-	for (int i = m_pieces.count() - 1; i >= 0; --i) {
-		Piece* other = m_pieces.at(i);
+	// Only check pieces that are near piece
+	for (Piece* other : m_piece_grid.find(marginRect(piece->boundingRect()))) {
 		if (other != piece && piece->collidesWith(other)) {
 			return other;
 		}
@@ -143,24 +241,76 @@ Piece* Board::findCollidingPiece(Piece* piece) const
 
 void Board::removePiece(Piece* piece)
 {
-	m_pieces.removeAll(piece);
-	delete piece;
+	m_pieces.remove(piece->handle());
+	m_piece_grid.remove(piece);
+	m_piece_chunks.remove(piece);
+	m_piece_arena.destroy(piece);
 	piece = 0;
 }
 
 //-----------------------------------------------------------------------------
 
+int Board::addPieceGroup(Piece* piece, const QList<Tile*>& tiles)
+{
+	int group = m_groups.add(tiles.count());
+	m_group_pieces.append(piece);
+	for (Tile* tile : tiles) {
+		m_tile_groups[(tile->row() * m_columns) + tile->column()] = group;
+	}
+	return group;
+}
+
+//-----------------------------------------------------------------------------
+
+int Board::joinPieceGroups(int first, int second, Piece* piece)
+{
+	int group = m_groups.join(first, second);
+	m_group_pieces[group] = piece;
+	return group;
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::pushPiece(Piece* piece, const QPointF& inertia)
+{
+	Push push = { piece->handle(), inertia };
+	m_pushes.append(push);
+	if (!m_settle_timer->isActive()) {
+		m_settle_timer->start();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::updatePieceGrid(Piece* piece)
+{
+	m_piece_grid.insert(piece, piece->boundingRect());
+	m_piece_chunks.insert(piece);
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::removeFromPieceGrid(Piece* piece)
+{
+	m_piece_grid.remove(piece);
+	m_piece_chunks.remove(piece);
+}
+
+//-----------------------------------------------------------------------------
+
 void Board::setAppearance(const AppearanceDialog& dialog)
 {
 	makeCurrent();
 
 	m_has_bevels = dialog.hasBevels();
 	m_has_shadows = dialog.hasShadows();
+	m_detail_size = dialog.detailSize();
+	m_board_layer_changed = true;
 
 	QPalette palette = dialog.colors();
 	graphics_layer->setClearColor(palette.color(QPalette::Base).darker(150));
 	setPalette(palette);
-	for (Piece* piece : m_pieces) {
+	for (Piece* piece : m_pieces.pieces(PieceStore::Resting)) {
 		piece->setSelected(piece->isSelected());
 	}
 }
@@ -176,6 +326,21 @@ void Board::updateSceneRectangle(Piece* piece)
 
 //-----------------------------------------------------------------------------
 
+QSize Board::puzzleSize(const QSizeF& image, int difficulty)
+{
+	int columns, rows;
+	if (image.width() > image.height()) {
+		columns = 4 * difficulty;
+		rows = std::max(std::lround(columns * image.height() / image.width()), 1L);
+	} else {
+		rows = 4 * difficulty;
+		columns = std::max(std::lround(rows * image.width() / image.height()), 1L);
+	}
+	return QSize(columns, rows);
+}
+
+//-----------------------------------------------------------------------------
+
 void Board::newGame(const QString& image, int difficulty)
 {
 	// Remove any previous textures and tiles
@@ -202,15 +367,11 @@ void Board::newGame(const QString& image, int difficulty)
 	m_id++;
 
 	// Find puzzle dimensions
-	QSizeF size = QImageReader(Path::image(image)).size();
-	if (size.width() > size.height()) {
-		m_columns = 4 * difficulty;
-		m_rows = std::max(std::lround(m_columns * size.height() / size.width()), 1L);
-	} else {
-		m_rows = 4 * difficulty;
-		m_columns = std::max(std::lround(m_rows * size.width() / size.height()), 1L);
-	}
+	QSize dimensions = puzzleSize(QImageReader(Path::image(image)).size(), difficulty);
+	m_columns = dimensions.width();
+	m_rows = dimensions.height();
 	m_total_pieces = (m_columns * m_rows) / 4;
+	m_tile_groups.fill(-1, m_columns * m_rows);
 
 	// Create textures
 	updateStatusMessage(tr("Loading image..."));
@@ -226,31 +387,29 @@ void Board::newGame(const QString& image, int difficulty)
 #else
 	m_random.seed(time(0));
 #endif
-	Generator generator(m_columns, m_rows, m_random);
-	QList< QList<Tile*> > pieces = generator.pieces();
+	QVector<DLX::Row> layout = LayoutCache::take(m_columns, m_rows);
+	if (layout.isEmpty()) {
+		Generator generator(m_columns, m_rows, m_random);
+		layout = generator.layout();
+	}
+	m_tile_arena.reserve(m_columns * m_rows);
+	QList< QList<Tile*> > pieces = Generator::pieces(layout, m_columns, m_tile_arena);
 	std::shuffle(pieces.begin(), pieces.end(), m_random);
 
 	updateStatusMessage(tr("Creating pieces..."));
 	int count = pieces.count();
+	m_piece_arena.reserve(count);
 	int step = (count > 25) ? (count / 25) : 1;
 	for (int i = 0; i < count; ++i) {
 		// Create piece
-		Piece* piece = new Piece(QPoint(0, 0), randomInt(4), pieces.at(i), this);
-		m_pieces.append(piece);
-		piece->setPosition(m_pos - QRect(QPoint(0,0), piece->boundingRect().size()).center());
-		piece->pushNeighbors();
+		addPiece(m_piece_arena.create(QPoint(0, 0), randomInt(4), pieces.at(i), this));
 
-		// Show pieces
+		// Show progress
 		if ((i % step) == 0) {
-			m_pos = m_scene.center();
-			update();
 			updateStatusMessage(tr("Creating pieces..."));
 		}
 	}
-
-	for (int i = 0; i < count; ++i) {
-		m_pieces.at(i)->findNeighbors(m_pieces);
-	}
+	scatterPieces(m_pieces.pieces(PieceStore::Resting));
 	emit clearMessage();
 
 	// Draw tiles
@@ -344,7 +503,7 @@ void Board::openGame(int id)
 			if (bevel) {
 				m_load_bevels = true;
 			}
-			Tile* tile = new Tile(column, row);
+			Tile* tile = m_tile_arena.create(column, row);
 			tile->setBevel(bevel);
 			tiles.append(tile);
 		} else if (xml.name() == QLatin1String("piece")) {
@@ -368,6 +527,7 @@ void Board::openGame(int id)
 		return;
 	}
 	m_total_pieces = (++m_columns * ++m_rows) / 4;
+	m_tile_groups.fill(-1, m_columns * m_rows);
 
 	// Load image
 	updateStatusMessage(tr("Loading image..."));
@@ -376,12 +536,10 @@ void Board::openGame(int id)
 	// Load pieces
 	updateStatusMessage(tr("Loading pieces..."));
 	int count = pieces.count();
+	m_piece_arena.reserve(count);
 	for (int i = 0; i < count; ++i) {
 		const PieceDetails& details = pieces.at(i);
-		m_pieces.append( new Piece(details.pos, details.rotation, details.tiles, this) );
-	}
-	for (int i = 0; i < count; ++i) {
-		m_pieces.at(i)->findNeighbors(m_pieces);
+		addPiece( m_piece_arena.create(details.pos, details.rotation, details.tiles, this) );
 	}
 	emit clearMessage();
 
@@ -413,6 +571,9 @@ void Board::saveGame()
 		return;
 	}
 
+	// Store where pieces end up instead of where they are in the middle of being pushed
+	settleAllPieces();
+
 	QFile file(Path::save(m_id));
 	if (!file.open(QIODevice::WriteOnly)) {
 		return;
@@ -436,14 +597,10 @@ void Board::saveGame()
 		.arg(m_scene.width())
 		.arg(m_scene.height()));
 
-	for (Piece* piece : m_pieces) {
-		piece->save(xml);
-	}
-	for (Piece* piece : m_selected_pieces) {
-		piece->save(xml);
-	}
-	for (Piece* piece : m_active_pieces) {
-		piece->save(xml);
+	for (int state = 0; state < PieceStore::StateCount; ++state) {
+		for (Piece* piece : m_pieces.pieces(PieceStore::State(state))) {
+			piece->save(xml);
+		}
 	}
 
 	xml.writeEndElement();
@@ -460,23 +617,25 @@ void Board::retrievePieces()
 	QApplication::setOverrideCursor(Qt::WaitCursor);
 
 	// Make sure all pieces are free
-	QList<Piece*> pieces = m_pieces + m_active_pieces + m_selected_pieces;
-	m_pieces.clear();
-	m_active_pieces.clear();
-	m_selected_pieces.clear();
+	QVector<Piece*> pieces = m_pieces.pieces(PieceStore::Resting)
+		+ m_pieces.pieces(PieceStore::Active)
+		+ m_pieces.pieces(PieceStore::Selected);
+	m_piece_grid.clear();
+	m_piece_chunks.clear();
+	m_pushes.clear();
 
 	// Clear view while retrieving pieces
 	m_pos = QPoint(0,0);
 	m_scene = QRect(0,0,0,0);
 
-	// Move all pieces to center of view
+	// Spread all pieces out around center of view
 	std::shuffle(pieces.begin(), pieces.end(), m_random);
 	for (Piece* piece : pieces) {
-		m_pieces.append(piece);
-		piece->setPosition(m_pos - QRect(QPoint(0,0), piece->boundingRect().size()).center());
+		m_pieces.setState(piece->handle(), PieceStore::Resting);
+		piece->setDepth(0);
 		piece->setSelected(false);
-		piece->pushNeighbors();
 	}
+	scatterPieces(pieces);
 
 	// Update view
 	zoomFit();
@@ -542,9 +701,10 @@ void Board::zoom(int level)
 
 	// Update mouse cursor position
 	QPoint new_pos = mapCursorPosition();
-	int count = m_active_pieces.count();
+	const QVector<Piece*>& active = m_pieces.pieces(PieceStore::Active);
+	int count = active.count();
 	for (int i = 0; i < count; ++i) {
-		m_active_pieces.at(i)->moveBy(new_pos - old_pos);
+		active.at(i)->moveBy(new_pos - old_pos);
 	}
 	updateCursor();
 
@@ -573,6 +733,8 @@ void Board::initializeGL()
 {
 	// Configure OpenGL
 	GraphicsLayer::init();
+	m_board_layer_supported = QOpenGLFramebufferObject::hasOpenGLFramebufferObjects()
+		&& QOpenGLContext::currentContext()->functions()->hasOpenGLFeature(QOpenGLFunctions::NPOTTextures);
 
 	// Load static images
 	m_bumpmap_image = new QOpenGLTexture(QImage(":/bumpmap.png"));
@@ -610,82 +772,47 @@ void Board::paintGL()
 {
 	graphics_layer->clear();
 
-	graphics_layer->uploadData();
+	// Simplify pieces when tiles are too small on screen to show bevels and shadows
+	const qreal pixelratio = devicePixelRatioF();
+	const bool detailed = (Tile::size * m_scale * pixelratio) >= m_detail_size;
+
+	const bool board_changed = m_piece_chunks.updateArrays(detailed);
 
 	// Transform viewport
-	const qreal pixelratio = devicePixelRatioF();
 	QRect viewport = rect();
 	viewport.setSize(viewport.size() * pixelratio);
 	QMatrix4x4 matrix;
 	matrix.scale(m_scale * pixelratio, m_scale * pixelratio);
 	matrix.translate((width() / (2 * m_scale)) - m_pos.x(), (height() / (2 * m_scale)) - m_pos.y());
-	graphics_layer->setModelview(matrix);
-
-	// Draw scene rectangle
-	QColor fill = palette().color(QPalette::Base);
-	QColor border = fill.lighter(125);
-	if (m_scene.isValid()) {
-		drawArray(m_scene_array, fill, border);
-	}
 
-	// Draw pieces
-	if (m_image) {
-		graphics_layer->bindTexture(0, m_image->textureId());
-		if (m_has_bevels && m_load_bevels) {
-			graphics_layer->setTextureUnits(2);
-			graphics_layer->bindTexture(1, m_bumpmap_image->textureId());
-		}
+	// Only redraw board under dragged pieces when it changes
+	const bool cached = updateBoardLayer(viewport.size());
 
-		int count = m_pieces.count();
-		for (int i = 0; i < count; ++i) {
-			QRect r = matrix.mapRect(m_pieces.at(i)->boundingRect());
-			if (viewport.intersects(r)) {
-				m_pieces.at(i)->drawTiles();
-			}
-		}
-
-		count = m_selected_pieces.count();
-		for (int i = 0; i < count; ++i) {
-			m_selected_pieces.at(i)->drawTiles();
-		}
+	graphics_layer->uploadData();
 
-		count = m_active_pieces.count();
-		for (int i = 0; i < count; ++i) {
-			m_active_pieces.at(i)->drawTiles();
+	if (cached) {
+		if (board_changed || m_board_layer_changed || (matrix != m_board_layer_matrix) || (m_scene != m_board_layer_scene)) {
+			m_board_layer->bind();
+			graphics_layer->clear();
+			graphics_layer->setModelview(matrix);
+			drawBoard(matrix, viewport, detailed);
+			m_board_layer->release();
+
+			m_board_layer_matrix = matrix;
+			m_board_layer_scene = m_scene;
+			m_board_layer_changed = false;
 		}
 
-		if (m_has_bevels) {
-			graphics_layer->setTextureUnits(1);
-		}
+		graphics_layer->setModelview(QMatrix4x4());
+		graphics_layer->bindTexture(0, m_board_layer->texture());
+		graphics_layer->draw(m_board_layer_array);
+	} else {
+		m_board_layer_changed = true;
+		graphics_layer->setModelview(matrix);
+		drawBoard(matrix, viewport, detailed);
 	}
 
-	// Draw shadows
-	graphics_layer->setBlended(true);
-	if (m_image && m_has_shadows) {
-		graphics_layer->bindTexture(0, m_shadow_image->textureId());
-
-		graphics_layer->setColor(palette().color(QPalette::Text));
-		int count = m_pieces.count();
-		for (int i = 0; i < count; ++i) {
-			QRect r = matrix.mapRect(m_pieces.at(i)->boundingRect());
-			if (viewport.intersects(r)) {
-				m_pieces.at(i)->drawShadow();
-			}
-		}
-
-		graphics_layer->setColor(palette().color(QPalette::Highlight));
-		count = m_selected_pieces.count();
-		for (int i = 0; i < count; ++i) {
-			m_selected_pieces.at(i)->drawShadow();
-		}
-
-		count = m_active_pieces.count();
-		for (int i = 0; i < count; ++i) {
-			m_active_pieces.at(i)->drawShadow();
-		}
-
-		graphics_layer->setColor(Qt::white);
-	}
+	drawPieces(matrix, detailed);
 
 	// Untransform viewport
 	if (qFuzzyCompare(pixelratio, 1.0)) {
@@ -698,7 +825,8 @@ void Board::paintGL()
 
 	// Draw selection rectangle
 	if (m_selecting) {
-		fill = border = palette().color(QPalette::Highlight);
+		QColor fill = palette().color(QPalette::Highlight);
+		QColor border = fill;
 		fill.setAlpha(48);
 		drawArray(m_selection_array, fill, border);
 	}
@@ -846,17 +974,16 @@ void Board::mouseMoveEvent(QMouseEvent* event)
 		scroll(delta);
 	}
 
-	if (!m_active_pieces.isEmpty()) {
-		int count = m_active_pieces.count();
+	const QVector<Piece*>& active = m_pieces.pieces(PieceStore::Active);
+	if (!active.isEmpty()) {
+		int count = active.count();
 		for (int i = 0; i < count; ++i) {
-			m_active_pieces.at(i)->moveBy(delta);
+			active.at(i)->moveBy(delta);
 		}
 
-		// Attach neighbors if only one piece is active
-		if (m_active_pieces.count() == 1) {
-			m_active_pieces.first()->attachNeighbors();
-			updateCompleted();
-		}
+		// Attach neighbors of all active pieces
+		attachPieces(active);
+		updateCompleted();
 
 		// Handle finishing game
 		if (pieceCount() == 1) {
@@ -871,22 +998,21 @@ void Board::mouseMoveEvent(QMouseEvent* event)
 		QRect rect = QRect(mapPosition(event->pos()), mapPosition(m_select_pos)).normalized();
 
 		// Check for pieces that are now selected
-		for (int i = 0; i < m_pieces.count(); ++i) {
-			Piece* piece = m_pieces.at(i);
+		for (Piece* piece : m_piece_grid.find(rect)) {
 			if (rect.intersects(piece->boundingRect())) {
 				piece->setSelected(true);
-				m_selected_pieces += m_pieces.takeAt(i);
-				i--;
+				m_pieces.setState(piece->handle(), PieceStore::Selected);
 			}
 		}
 
-		// Check for pieces that are no longer selected
-		for (int i = 0; i < m_selected_pieces.count(); ++i) {
-			Piece* piece = m_selected_pieces.at(i);
+		// Check for pieces that are no longer selected; walk backwards because
+		// removing a piece moves the last piece into its place
+		const QVector<Piece*>& selected = m_pieces.pieces(PieceStore::Selected);
+		for (int i = selected.count() - 1; i >= 0; --i) {
+			Piece* piece = selected.at(i);
 			if (!rect.intersects(piece->boundingRect())) {
 				piece->setSelected(false);
-				m_pieces += m_selected_pieces.takeAt(i);
-				i--;
+				m_pieces.setState(piece->handle(), PieceStore::Resting);
 			}
 		}
 
@@ -936,9 +1062,10 @@ void Board::stopScrolling()
 void Board::scroll(const QPoint& delta)
 {
 	m_pos -= delta;
-	int count = m_active_pieces.count();
+	const QVector<Piece*>& active = m_pieces.pieces(PieceStore::Active);
+	int count = active.count();
 	for (int i = 0; i < count; ++i) {
-		m_active_pieces.at(i)->moveBy(-delta);
+		active.at(i)->moveBy(-delta);
 	}
 }
 
@@ -995,9 +1122,8 @@ void Board::grabPiece()
 	if (piece == 0) {
 		return;
 	}
-	m_active_pieces.append(piece);
-	m_pieces.removeAll(piece);
-	piece->setDepth(m_active_pieces.count() + 1);
+	m_pieces.setState(piece->handle(), PieceStore::Active);
+	piece->setDepth(m_pieces.pieces(PieceStore::Active).count() + 1);
 	piece->setSelected(true);
 	updateCursor();
 
@@ -1012,35 +1138,24 @@ void Board::releasePieces()
 		return;
 	}
 
-	// Inform user this may take awhile
-	updateStatusMessage(tr("Placing pieces..."));
-	QApplication::setOverrideCursor(Qt::WaitCursor);
-
-	// Attach to closest piece
-	int count = m_active_pieces.count();
-	if (count == 1) {
-		m_active_pieces.first()->attachNeighbors();
-		updateCompleted();
-	}
+	// Attach to closest pieces
+	attachPieces(m_pieces.pieces(PieceStore::Active));
 
 	// Place pieces
+	const QVector<Piece*> active = m_pieces.pieces(PieceStore::Active);
+	int count = active.count();
 	Piece* piece;
 	for (int i = 0; i < count; ++i) {
-		piece = m_active_pieces.at(i);
-		m_pieces.append(piece);
+		piece = active.at(i);
+		m_pieces.setState(piece->handle(), PieceStore::Resting);
 		piece->setDepth(0);
 		piece->setSelected(false);
-		piece->pushNeighbors();
+		pushPiece(piece);
 	}
-	m_active_pieces.clear();
 
 	updateCursor();
 	updateCompleted();
 
-	// Clear message and cursor
-	emit clearMessage();
-	QApplication::restoreOverrideCursor();
-
 	// Check if game is over
 	if (pieceCount() == 1) {
 		finishGame();
@@ -1057,18 +1172,19 @@ void Board::rotatePiece()
 		return;
 	}
 
-	if (m_active_pieces.isEmpty()) {
+	const QVector<Piece*>& active = m_pieces.pieces(PieceStore::Active);
+	if (active.isEmpty()) {
 		Piece* piece = pieceUnderCursor();
 		if (piece == 0) {
 			return;
 		}
 		piece->rotate(mapCursorPosition());
 		piece->attachNeighbors();
-		piece->pushNeighbors();
+		pushPiece(piece);
 	} else {
-		int count = m_active_pieces.count();
+		int count = active.count();
 		for (int i = 0; i < count; ++i) {
-			m_active_pieces.at(i)->rotate(mapCursorPosition());
+			active.at(i)->rotate(mapCursorPosition());
 		}
 	}
 	updateCompleted();
@@ -1087,17 +1203,17 @@ void Board::selectPieces()
 	m_selecting = false;
 
 	QPoint cursor = mapCursorPosition();
-	int depth = m_active_pieces.count() + 1;
-	int count = m_selected_pieces.count();
+	int depth = m_pieces.pieces(PieceStore::Active).count() + 1;
+	const QVector<Piece*> selected = m_pieces.pieces(PieceStore::Selected);
+	int count = selected.count();
 	for (int i = 0; i < count; ++i) {
-		Piece* piece = m_selected_pieces.at(i);
+		Piece* piece = selected.at(i);
 		piece->setDepth(depth + i);
 		if (!piece->contains(cursor)) {
 			piece->moveBy(cursor - piece->randomPoint());
 		}
+		m_pieces.setState(piece->handle(), PieceStore::Active);
 	}
-	m_active_pieces += m_selected_pieces;
-	m_selected_pieces.clear();
 
 	update();
 	updateCursor();
@@ -1105,6 +1221,86 @@ void Board::selectPieces()
 
 //-----------------------------------------------------------------------------
 
+void Board::scatterPieces(const QVector<Piece*>& pieces)
+{
+	// Pack pieces into rows that fill the view, so that no pieces have to be pushed apart
+	QVector<QSize> sizes;
+	sizes.reserve(pieces.count());
+	for (Piece* piece : pieces) {
+		sizes.append(piece->boundingRect().size());
+	}
+	const qreal aspect = qreal(std::max(width(), 1)) / qreal(std::max(height(), 1));
+	QVector<QPoint> positions = packShelves(sizes, margin(), Tile::size / 2, aspect, m_random);
+
+	// Every piece moves, so rebuild grid instead of updating it one piece at a time
+	m_piece_grid.clear();
+	m_piece_chunks.clear();
+	for (int i = 0; i < pieces.count(); ++i) {
+		pieces.at(i)->setPosition(m_pos + positions.at(i));
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::settlePieces()
+{
+	// Move pieces out of the way one at a time, limiting how long the board is blocked
+	QElapsedTimer timer;
+	timer.start();
+	while (!m_pushes.isEmpty() && !timer.hasExpired(settle_time)) {
+		Push push = m_pushes.takeFirst();
+
+		// Skip pieces that were attached to others since being pushed, and
+		// settle pieces that were picked up when they are put down again
+		Piece* piece = m_pieces.piece(push.piece);
+		if (piece && !piece->isSelected()) {
+			piece->pushNeighbors(push.inertia);
+		}
+	}
+
+	if (m_pushes.isEmpty()) {
+		m_settle_timer->stop();
+	}
+	update();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::settleAllPieces()
+{
+	while (!m_pushes.isEmpty()) {
+		settlePieces();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::addPiece(Piece* piece)
+{
+	piece->setHandle(m_pieces.insert(piece));
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::attachPieces(const QVector<Piece*>& pieces)
+{
+	// Pieces can be attached to one earlier in the batch, so look them up by handle
+	QVector<PieceStore::Handle> handles;
+	handles.reserve(pieces.count());
+	for (Piece* piece : pieces) {
+		handles.append(piece->handle());
+	}
+
+	// Only edges of each piece are checked, so cost depends on pieces in batch and not on board
+	for (const PieceStore::Handle& handle : handles) {
+		if (Piece* piece = m_pieces.piece(handle)) {
+			piece->attachNeighbors();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 void Board::drawArray(const Region& region, const QColor& fill, const QColor& border)
 {
 	graphics_layer->setTextureUnits(0);
@@ -1122,6 +1318,94 @@ void Board::drawArray(const Region& region, const QColor& fill, const QColor& bo
 
 //-----------------------------------------------------------------------------
 
+void Board::drawBoard(const QMatrix4x4& matrix, const QRect& viewport, bool detailed)
+{
+	// Draw scene rectangle
+	QColor fill = palette().color(QPalette::Base);
+	QColor border = fill.lighter(125);
+	if (m_scene.isValid()) {
+		drawArray(m_scene_array, fill, border);
+	}
+
+	if (!m_image) {
+		return;
+	}
+
+	// Draw resting pieces
+	graphics_layer->bindTexture(0, m_image->textureId());
+	if (detailed && m_has_bevels && m_load_bevels) {
+		graphics_layer->setTextureUnits(2);
+		graphics_layer->bindTexture(1, m_bumpmap_image->textureId());
+	}
+	m_piece_chunks.drawTiles(matrix, viewport);
+	if (m_has_bevels) {
+		graphics_layer->setTextureUnits(1);
+	}
+
+	// Draw shadows of resting pieces
+	if (detailed && m_has_shadows) {
+		graphics_layer->setBlended(true);
+		graphics_layer->bindTexture(0, m_shadow_image->textureId());
+		graphics_layer->setColor(palette().color(QPalette::Text));
+		m_piece_chunks.drawShadows(matrix, viewport);
+		graphics_layer->setColor(Qt::white);
+		graphics_layer->setBlended(false);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::drawPieces(const QMatrix4x4& matrix, bool detailed)
+{
+	// Draw pieces
+	if (m_image) {
+		graphics_layer->bindTexture(0, m_image->textureId());
+		if (detailed && m_has_bevels && m_load_bevels) {
+			graphics_layer->setTextureUnits(2);
+			graphics_layer->bindTexture(1, m_bumpmap_image->textureId());
+		}
+
+		const QVector<Piece*>& selected = m_pieces.pieces(PieceStore::Selected);
+		int count = selected.count();
+		for (int i = 0; i < count; ++i) {
+			selected.at(i)->drawTiles(matrix);
+		}
+
+		const QVector<Piece*>& active = m_pieces.pieces(PieceStore::Active);
+		count = active.count();
+		for (int i = 0; i < count; ++i) {
+			active.at(i)->drawTiles(matrix);
+		}
+
+		if (m_has_bevels) {
+			graphics_layer->setTextureUnits(1);
+		}
+	}
+
+	// Draw shadows
+	graphics_layer->setBlended(true);
+	if (detailed && m_image && m_has_shadows) {
+		graphics_layer->bindTexture(0, m_shadow_image->textureId());
+
+		graphics_layer->setColor(palette().color(QPalette::Highlight));
+		const QVector<Piece*>& selected = m_pieces.pieces(PieceStore::Selected);
+		int count = selected.count();
+		for (int i = 0; i < count; ++i) {
+			selected.at(i)->drawShadow(matrix);
+		}
+
+		const QVector<Piece*>& active = m_pieces.pieces(PieceStore::Active);
+		count = active.count();
+		for (int i = 0; i < count; ++i) {
+			active.at(i)->drawShadow(matrix);
+		}
+
+		graphics_layer->setColor(Qt::white);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 void Board::loadImage()
 {
 	// Record currently open image
@@ -1159,6 +1443,7 @@ void Board::loadImage()
 
 	int image_texture_size = powerOfTwo(std::max(size.width(), size.height()));
 	m_image_ts = static_cast<float>(tile_size) / static_cast<float>(image_texture_size);
+	graphics_layer->setTileSize(Tile::size, m_image_ts);
 	QImage texture(image_texture_size, image_texture_size, QImage::Format_ARGB32);
 	texture.fill(QColor(Qt::darkGray).rgba());
 	{
@@ -1201,7 +1486,7 @@ void Board::updateCursor()
 {
 	int state = 0;
 	if (!m_finished) {
-		state = (pieceUnderCursor() != 0 || m_selecting) | (!m_active_pieces.isEmpty() * 2);
+		state = (pieceUnderCursor() != 0 || m_selecting) | (!m_pieces.pieces(PieceStore::Active).isEmpty() * 2);
 	}
 
 	switch (state) {
@@ -1277,10 +1562,51 @@ void Board::updateArray(Region& region, const QRect& rect, int z)
 
 //-----------------------------------------------------------------------------
 
+bool Board::updateBoardLayer(const QSize& size)
+{
+	// Board is only cached while nothing but dragged pieces are moving
+	if (!m_board_layer_supported
+			|| !m_image
+			|| m_pieces.pieces(PieceStore::Active).isEmpty()
+			|| !m_pieces.pieces(PieceStore::Selected).isEmpty()) {
+		return false;
+	}
+	if (m_board_layer && (m_board_layer->size() == size)) {
+		return true;
+	}
+
+	delete m_board_layer;
+	m_board_layer = new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::Depth);
+	if (!m_board_layer->isValid()) {
+		delete m_board_layer;
+		m_board_layer = nullptr;
+		m_board_layer_supported = false;
+		return false;
+	}
+	m_board_layer_changed = true;
+
+	// Texture of framebuffer is upside down
+	const int w = size.width();
+	const int h = size.height();
+	graphics_layer->updateArray(m_board_layer_array,
+	{
+		Vertex::init(0,0,0, 0,1),
+		Vertex::init(0,h,0, 0,0),
+		Vertex::init(w,0,0, 1,1),
+		Vertex::init(w,0,0, 1,1),
+		Vertex::init(0,h,0, 0,0),
+		Vertex::init(w,h,0, 1,0)
+	});
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
 void Board::updateSceneRectangle()
 {
 	m_scene = QRect(0,0,0,0);
-	for (Piece* piece : m_pieces) {
+	for (Piece* piece : m_pieces.pieces(PieceStore::Resting)) {
 		updateSceneRectangle(piece);
 	}
 }
@@ -1296,10 +1622,9 @@ void Board::updateStatusMessage(const QString& message)
 
 Piece* Board::pieceUnderCursor()
 {
+	// Pieces on the board do not overlap, so only one can contain cursor
 	QPoint pos = mapCursorPosition();
-	Piece* piece;
-	for (int i = m_pieces.count() - 1; i >= 0; --i) {
-		piece = m_pieces.at(i);
+	for (Piece* piece : m_piece_grid.find(QRect(pos, QSize(1, 1)))) {
 		if (piece->contains(pos)) {
 			return piece;
 		}
@@ -1311,7 +1636,7 @@ Piece* Board::pieceUnderCursor()
 
 int Board::pieceCount()
 {
-	return m_pieces.count() + m_active_pieces.count() + m_selected_pieces.count();
+	return m_groups.count();
 }
 
 //-----------------------------------------------------------------------------
@@ -1321,13 +1646,14 @@ void Board::finishGame()
 	m_finished = true;
 
 	// Drop remaining piece
-	if (!m_active_pieces.isEmpty()) {
-		m_pieces.append(m_active_pieces.first());
+	const QVector<Piece*> active = m_pieces.pieces(PieceStore::Active);
+	for (Piece* piece : active) {
+		m_pieces.setState(piece->handle(), PieceStore::Resting);
+		piece->setDepth(0);
 	}
-	m_active_pieces.clear();
 
 	// Rotate completed board to face up
-	Piece* piece = m_pieces.first();
+	Piece* piece = m_pieces.pieces(PieceStore::Resting).first();
 	if (piece->rotation() > 0) {
 		for (int i = piece->rotation(); i < 4; ++i) {
 			piece->rotate();
@@ -1364,10 +1690,21 @@ void Board::cleanup()
 	emit clearMessage();
 	m_overview->reset();
 	m_message->setVisible(false);
-	m_active_pieces.clear();
-	m_selected_pieces.clear();
-	qDeleteAll(m_pieces);
+	for (int state = 0; state < PieceStore::StateCount; ++state) {
+		for (Piece* piece : m_pieces.pieces(PieceStore::State(state))) {
+			m_piece_arena.destroy(piece);
+		}
+	}
 	m_pieces.clear();
+	m_piece_arena.clear();
+	m_tile_arena.clear();
+	m_piece_grid.clear();
+	m_piece_chunks.clear();
+	m_pushes.clear();
+	m_settle_timer->stop();
+	m_groups.clear();
+	m_group_pieces.clear();
+	m_tile_groups.clear();
 	m_completed = 0;
 	m_id = 0;
 	m_columns = 0;
@@ -20,7 +20,12 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include "arena.h"
 #include "graphics_layer.h"
+#include "piece_chunks.h"
+#include "piece_grid.h"
+#include "piece_groups.h"
+#include "piece_store.h"
 class AppearanceDialog;
 class Message;
 class Overview;
@@ -35,7 +40,9 @@ typedef QOpenGLWidget GLWidget;
 #include <QGLWidget>
 typedef QGLWidget GLWidget;
 #endif
+class QOpenGLFramebufferObject;
 class QOpenGLTexture;
+class QTimer;
 
 #include <random>
 
@@ -49,12 +56,24 @@ class Board : public GLWidget
 		VertexArray border;
 	};
 
+	struct Push
+	{
+		PieceStore::Handle piece;
+		QPointF inertia;
+	};
+
 public:
 	Board(QWidget* parent = 0);
 	~Board();
 
 	Piece* findCollidingPiece(Piece* piece) const;
 	void removePiece(Piece* piece);
+	void pushPiece(Piece* piece, const QPointF& inertia = QPointF());
+	void updatePieceGrid(Piece* piece);
+	void removeFromPieceGrid(Piece* piece);
+	int addPieceGroup(Piece* piece, const QList<Tile*>& tiles);
+	int joinPieceGroups(int first, int second, Piece* piece);
+	Piece* tileOwner(int column, int row) const;
 
 	int id() const;
 	int margin() const;
@@ -65,6 +84,8 @@ public:
 	void setAppearance(const AppearanceDialog& dialog);
 	void updateSceneRectangle(Piece* piece);
 
+	static QSize puzzleSize(const QSizeF& image, int difficulty);
+
 public slots:
 	void newGame(const QString& image, int difficulty);
 	void openGame(int id);
@@ -108,14 +129,22 @@ private:
 	void releasePieces();
 	void rotatePiece();
 	void selectPieces();
+	void scatterPieces(const QVector<Piece*>& pieces);
+	void settlePieces();
+	void settleAllPieces();
 
+	void addPiece(Piece* piece);
+	void attachPieces(const QVector<Piece*>& pieces);
 	void drawArray(const Region& region, const QColor& fill, const QColor& border);
+	void drawBoard(const QMatrix4x4& matrix, const QRect& viewport, bool detailed);
+	void drawPieces(const QMatrix4x4& matrix, bool detailed);
 	void loadImage();
 	void updateCursor();
 	QPoint mapCursorPosition() const;
 	QPoint mapPosition(const QPoint& position) const;
 	void updateCompleted();
 	void updateArray(Region& region, const QRect& rect, int z);
+	bool updateBoardLayer(const QSize& size);
 	void updateSceneRectangle();
 	void updateStatusMessage(const QString& message);
 	Piece* pieceUnderCursor();
@@ -135,6 +164,7 @@ private:
 	Message* m_message;
 	bool m_has_bevels;
 	bool m_has_shadows;
+	int m_detail_size;
 
 	QOpenGLTexture* m_image;
 	QOpenGLTexture* m_bumpmap_image;
@@ -144,11 +174,25 @@ private:
 	Region m_scene_array;
 	Region m_selection_array;
 
+	QOpenGLFramebufferObject* m_board_layer;
+	VertexArray m_board_layer_array;
+	QMatrix4x4 m_board_layer_matrix;
+	QRect m_board_layer_scene;
+	bool m_board_layer_supported;
+	bool m_board_layer_changed;
+
 	int m_columns;
 	int m_rows;
-	QList<Piece*> m_pieces;
-	QList<Piece*> m_active_pieces;
-	QList<Piece*> m_selected_pieces;
+	PieceGroups m_groups;
+	QVector<Piece*> m_group_pieces;
+	QVector<int> m_tile_groups;
+	Arena<Tile> m_tile_arena;
+	Arena<Piece> m_piece_arena;
+	PieceStore m_pieces;
+	PieceGrid m_piece_grid;
+	PieceChunks m_piece_chunks;
+	QList<Push> m_pushes;
+	QTimer* m_settle_timer;
 	QRect m_scene;
 	int m_total_pieces;
 	int m_completed;
@@ -174,6 +218,15 @@ inline int Board::id() const
 	return m_id;
 }
 
+inline Piece* Board::tileOwner(int column, int row) const
+{
+	if ((column < 0) || (column >= m_columns) || (row < 0) || (row >= m_rows)) {
+		return 0;
+	}
+	int group = m_tile_groups.at((row * m_columns) + column);
+	return (group != -1) ? m_group_pieces.at(m_groups.find(group)) : 0;
+}
+
 inline int Board::margin() const
 {
 	return 16;
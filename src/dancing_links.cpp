@@ -19,45 +19,61 @@
 
 #include "dancing_links.h"
 
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 
-DLX::Matrix::Matrix(unsigned int max_columns) :
-	m_max_columns(max_columns),
-	m_columns(max_columns),
-	m_output(max_columns),
-	m_solutions(0),
-	m_tries(0)
+static unsigned int luby(unsigned int index)
 {
-	m_header = new HeaderNode;
-	m_header->column = m_header;
-
-	Node* node = m_header;
-	HeaderNode* column = 0;
-	for (unsigned int i = 0; i < m_max_columns; ++i) {
-		column = &m_columns[i];
-		column->id = i;
-		column->up = column->down = column->column = column;
-		column->left = node;
-		node->right = column;
-		node = column;
+	// Find the smallest complete subsequence that contains index
+	unsigned int size = 1;
+	unsigned int power = 0;
+	while (size < index + 1) {
+		++power;
+		size = (size * 2) + 1;
 	}
-	node->right = m_header;
+
+	// Descend into the subsequences that contain index
+	while (size - 1 != index) {
+		size = (size - 1) / 2;
+		--power;
+		index %= size;
+	}
+
+	return 1u << power;
 }
 
 //-----------------------------------------------------------------------------
 
-DLX::Matrix::~Matrix()
+DLX::Matrix::Matrix(unsigned int max_columns, unsigned int max_elements) :
+	m_max_columns(max_columns),
+	m_sizes(max_columns + 1, 0),
+	m_row(0),
+	m_stack(max_columns),
+	m_cancelled(nullptr),
+	m_random(nullptr),
+	m_max_restarts(0),
+	m_solutions(0),
+	m_tries(0)
 {
-	delete m_header;
+	m_nodes.reserve(max_columns + 1 + max_elements);
+	m_nodes.resize(max_columns + 1);
+
+	// Link root and column headers into a horizontal ring
+	for (quint32 i = 0; i <= m_max_columns; ++i) {
+		Node& column = m_nodes[i];
+		column.left = (i > 0) ? (i - 1) : m_max_columns;
+		column.right = (i < m_max_columns) ? (i + 1) : 0;
+		column.up = column.down = column.column = i;
+	}
 }
 
 //-----------------------------------------------------------------------------
 
 void DLX::Matrix::addRow()
 {
-	m_rows.append(HeaderNode());
-	HeaderNode* row = &m_rows.last();
-	row->left = row->right = row->up = row->down = row->column = row;
+	m_row = m_nodes.count();
+	++m_statistics.rows;
 }
 
 //-----------------------------------------------------------------------------
@@ -65,26 +81,50 @@ void DLX::Matrix::addRow()
 void DLX::Matrix::addElement(unsigned int c)
 {
 	Q_ASSERT(c < m_max_columns);
+	Q_ASSERT(m_row != 0);
 
-	HeaderNode* column = &m_columns[c];
-	HeaderNode* row = &m_rows.last();
-
+	quint32 column = c + 1;
+	quint32 index = m_nodes.count();
 	m_nodes.append(Node());
-	Node* node = &m_nodes.last();
 
-	node->left = row->left;
-	node->right = row;
-	row->left->right = node;
-	row->left = node;
+	Node* nodes = m_nodes.data();
+	Node& node = nodes[index];
+
+	if (index == m_row) {
+		node.left = node.right = index;
+	} else {
+		Node& row = nodes[m_row];
+		node.left = row.left;
+		node.right = m_row;
+		nodes[row.left].right = index;
+		row.left = index;
+	}
 
-	node->up = column->up;
-	node->down = column;
-	column->up->down = node;
-	column->up = node;
+	Node& header = nodes[column];
+	node.up = header.up;
+	node.down = column;
+	nodes[header.up].down = index;
+	header.up = index;
 
-	node->column = column;
+	node.column = column;
 
-	column->size++;
+	m_sizes[column]++;
+	++m_statistics.nodes;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::Matrix::setCancelled(const QAtomicInt* cancelled)
+{
+	m_cancelled = cancelled;
+}
+
+//-----------------------------------------------------------------------------
+
+void DLX::Matrix::setRestarts(std::mt19937* random, unsigned int max_restarts)
+{
+	m_random = random;
+	m_max_restarts = max_restarts;
 }
 
 //-----------------------------------------------------------------------------
@@ -96,91 +136,202 @@ unsigned int DLX::Matrix::search(Callback* solution, unsigned int max_solutions,
 	m_solutions = 0;
 	m_max_solutions = max_solutions;
 
-	m_tries = 0;
-	m_max_tries = (max_tries != 0) ? max_tries : m_max_columns;
+	if (max_tries == 0) {
+		max_tries = m_max_columns;
+	}
+
+	for (unsigned int restart = 0; ; ++restart) {
+		m_tries = 0;
+		m_max_tries = std::min<quint64>(quint64(max_tries) * luby(restart), 0xFFFFFFFF);
+
+		solve();
+		m_statistics.tries += m_tries;
+		m_statistics.max_tries += m_max_tries;
+
+		// Only restart if the search ran out of tries without finding anything
+		if ((m_solutions > 0) || (m_tries < m_max_tries) || (restart >= m_max_restarts)) {
+			break;
+		}
+		++m_statistics.restarts;
+	}
 
-	solve(0);
+	m_statistics.solutions += m_solutions;
 	return m_solutions;
 }
 
 //-----------------------------------------------------------------------------
 
-void DLX::Matrix::solve(unsigned int k)
+void DLX::Matrix::solve()
 {
-	// If matrix is empty a solution has been found.
-	if (m_header->right == m_header) {
-		++m_solutions;
-		(*m_solution)(m_output, k);
-		return;
-	}
+	const Node* nodes = m_nodes.constData();
+	const quint32* sizes = m_sizes.constData();
+	Frame* stack = m_stack.data();
+
+	unsigned int k = 0;
+	bool descend = true;
+	for (;;) {
+		if (descend) {
+			// If matrix is empty a solution has been found.
+			if (nodes[0].right == 0) {
+				++m_solutions;
+				report(k);
+				if (m_solutions >= m_max_solutions) {
+					break;
+				}
+			} else if ((m_solutions >= m_max_solutions) || (++m_tries >= m_max_tries)) {
+				break;
+			} else if (m_cancelled && m_cancelled->loadAcquire()) {
+				break;
+			} else {
+				// Choose column with lowest amount of 1s.
+				quint32 column = 0;
+				quint32 s = 0xFFFFFFFF;
+				for (quint32 i = nodes[0].right; i != 0; i = nodes[i].right) {
+					if (sizes[i] < s) {
+						column = i;
+						s = sizes[i];
+					}
+				}
+				cover(column);
+
+				Frame& frame = stack[k];
+				frame.column = column;
+				frame.row = column;
+				frame.first = nodes[column].down;
+				if (m_random && (s > 1)) {
+					for (quint32 i = std::uniform_int_distribution<quint32>(0, s - 1)(*m_random); i > 0; --i) {
+						frame.first = nodes[frame.first].down;
+					}
+				}
+				++k;
+			}
+		}
 
-	if ((m_solutions >= m_max_solutions) || (++m_tries >= m_max_tries)) {
-		return;
-	}
+		// Search is finished if there are no more rows to try
+		if (k == 0) {
+			break;
+		}
+
+		// Move to next row in column of current depth, wrapping around past the header
+		Frame& frame = stack[k - 1];
+		if (frame.row == frame.column) {
+			frame.row = frame.first;
+		} else {
+			uncoverRow(frame.row);
+			frame.row = nodes[frame.row].down;
+			if (frame.row == frame.column) {
+				frame.row = nodes[frame.row].down;
+			}
+			if (frame.row == frame.first) {
+				frame.row = frame.column;
+			}
+		}
 
-	// Choose column with lowest amount of 1s.
-	HeaderNode* column = 0;
-	unsigned int s = 0xFFFFFFFF;
-	for(HeaderNode* i = m_header->right->column; i != m_header; i = i->right->column) {
-		if (i->size < s) {
-			column = i;
-			s = i->size;
+		if (frame.row != frame.column) {
+			coverRow(frame.row);
+			descend = true;
+		} else {
+			uncover(frame.column);
+			--k;
+			descend = false;
+			++m_statistics.backtracks;
 		}
 	}
-	cover(column);
 
-	unsigned int next_k = k + 1;
+	// Restore matrix if search was stopped early
+	while (k > 0) {
+		const Frame& frame = stack[--k];
+		if (frame.row != frame.column) {
+			uncoverRow(frame.row);
+		}
+		uncover(frame.column);
+	}
+}
 
-	for(Node* row = column->down; row != column; row = row->down) {
-		m_output[k] = row;
+//-----------------------------------------------------------------------------
 
-		for(Node* j = row->right; j != row; j = j->right) {
-			cover(j->column);
-		}
+void DLX::Matrix::report(unsigned int k)
+{
+	const Node* nodes = m_nodes.constData();
+
+	QVector<Row> rows(k);
+	for (unsigned int i = 0; i < k; ++i) {
+		quint32 node = m_stack.at(i).row;
+		Row& row = rows[i];
+		quint32 j = node;
+		do {
+			row.append(nodes[j].column - 1);
+			j = nodes[j].right;
+		} while (j != node);
+	}
 
-		solve(next_k);
+	(*m_solution)(rows);
+}
 
-		row = m_output[k];
-		column = row->column;
+//-----------------------------------------------------------------------------
 
-		for(Node* j = row->left; j != row; j = j->left) {
-			uncover(j->column);
-		}
+void DLX::Matrix::coverRow(quint32 row)
+{
+	const Node* nodes = m_nodes.constData();
+	for (quint32 j = nodes[row].right; j != row; j = nodes[j].right) {
+		cover(nodes[j].column);
 	}
+}
 
-	uncover(column);
+//-----------------------------------------------------------------------------
+
+void DLX::Matrix::uncoverRow(quint32 row)
+{
+	const Node* nodes = m_nodes.constData();
+	for (quint32 j = nodes[row].left; j != row; j = nodes[j].left) {
+		uncover(nodes[j].column);
+	}
 }
 
 //-----------------------------------------------------------------------------
 
-void DLX::Matrix::cover(HeaderNode* node)
+void DLX::Matrix::cover(quint32 column)
 {
-	node->right->left = node->left;
-	node->left->right = node->right;
-
-	for (Node* i = node->down; i != node; i = i->down) {
-		for (Node* j = i->right; j != i; j = j->right) {
-			j->down->up = j->up;
-			j->up->down = j->down;
-			j->column->size--;
+	Node* nodes = m_nodes.data();
+	quint32* sizes = m_sizes.data();
+
+	++m_statistics.covers;
+
+	Node& header = nodes[column];
+	nodes[header.right].left = header.left;
+	nodes[header.left].right = header.right;
+
+	for (quint32 i = header.down; i != column; i = nodes[i].down) {
+		for (quint32 j = nodes[i].right; j != i; j = nodes[j].right) {
+			const Node& node = nodes[j];
+			nodes[node.down].up = node.up;
+			nodes[node.up].down = node.down;
+			sizes[node.column]--;
 		}
 	}
 }
 
 //-----------------------------------------------------------------------------
 
-void DLX::Matrix::uncover(HeaderNode* node)
+void DLX::Matrix::uncover(quint32 column)
 {
-	for (Node* i = node->up; i != node; i = i->up) {
-		for (Node* j = i->left; j != i; j = j->left) {
-			j->column->size++;
-			j->down->up = j;
-			j->up->down = j;
+	Node* nodes = m_nodes.data();
+	quint32* sizes = m_sizes.data();
+
+	++m_statistics.uncovers;
+
+	Node& header = nodes[column];
+	for (quint32 i = header.up; i != column; i = nodes[i].up) {
+		for (quint32 j = nodes[i].left; j != i; j = nodes[j].left) {
+			const Node& node = nodes[j];
+			sizes[node.column]++;
+			nodes[node.down].up = j;
+			nodes[node.up].down = j;
 		}
 	}
 
-	node->right->left = node;
-	node->left->right = node;
+	nodes[header.right].left = column;
+	nodes[header.left].right = column;
 }
 
 //-----------------------------------------------------------------------------
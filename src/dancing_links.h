@@ -20,9 +20,11 @@
 #ifndef TETZLE_DANCING_LINKS_H
 #define TETZLE_DANCING_LINKS_H
 
-#include <QLinkedList>
+#include <QAtomicInt>
 #include <QVector>
 
+#include <random>
+
 /**
  * Dancing Links implementation of Algorithm X.
  *
@@ -35,126 +37,161 @@
  * Algorithm X you represent each constraint by a column. Each possible value
  * is then placed into a row with 1s in the columns for the constraints it
  * matches.
+ *
+ * All nodes are stored in a single contiguous array and link to each other
+ * by 32-bit index instead of by pointer. Index 0 is the root element, the
+ * indices 1 to @c max_columns are the column headers, and the elements of
+ * each row follow in the order they were added.
  */
 namespace DLX
 {
 
-struct HeaderNode;
+/** Columns of a row in a solution. */
+typedef QVector<unsigned int> Row;
 
 /** %Node in matrix. */
 struct Node
 {
-	/** Constructs a node with the value of 1. */
-	Node() :
-		left(0),
-		right(0),
-		up(0),
-		down(0),
-		column(0)
+	quint32 left; /**< index of node to the left with value of 1 */
+	quint32 right; /**< index of node to the right with value of 1 */
+	quint32 up; /**< index of node above with value of 1 */
+	quint32 down; /**< index of node below with value of 1 */
+	quint32 column; /**< index of column header containing this node */
+};
+
+/** Counters of the work done by a matrix. */
+struct Statistics
+{
+	/** Constructs statistics with every counter at zero. */
+	Statistics() :
+		rows(0),
+		nodes(0),
+		covers(0),
+		uncovers(0),
+		backtracks(0),
+		tries(0),
+		max_tries(0),
+		restarts(0),
+		solutions(0)
 	{
 	}
 
-	Node* left; /**< node to the left with value of 1 */
-	Node* right; /**< node to the right with value of 1 */
-	Node* up; /**< node above with value of 1 */
-	Node* down; /**< node below with value of 1 */
-	HeaderNode* column; /**< column containing this node */
+	/** Add the counters of @p other to these counters. */
+	Statistics& operator+=(const Statistics& other)
+	{
+		rows += other.rows;
+		nodes += other.nodes;
+		covers += other.covers;
+		uncovers += other.uncovers;
+		backtracks += other.backtracks;
+		tries += other.tries;
+		max_tries += other.max_tries;
+		restarts += other.restarts;
+		solutions += other.solutions;
+		return *this;
+	}
+
+	quint64 rows; /**< how many rows were added */
+	quint64 nodes; /**< how many elements were added */
+	quint64 covers; /**< how many times a column was removed */
+	quint64 uncovers; /**< how many times a column was added back */
+	quint64 backtracks; /**< how many times every row of a column had been tried */
+	quint64 tries; /**< how many attempts were made, over every restart */
+	quint64 max_tries; /**< how many attempts were allowed, over every restart */
+	quint64 restarts; /**< how many times a search started over */
+	quint64 solutions; /**< how many solutions were found */
 };
 
-/** Head node of column or row in matrix. */
-struct HeaderNode : public Node
+/** Abstract base class for solution callback. */
+class Callback
 {
-	/** Constructs an empty column. */
-	HeaderNode() :
-		size(0),
-		id(0)
+public:
+	/** Destroy collback. */
+	virtual ~Callback()
 	{
 	}
 
-	unsigned int size; /**< how many nodes with value of 1 are in column */
-	unsigned int id; /**< unique identifier */
+	/** Empty function to allow for ignored callbacks. */
+	virtual void operator()(const QVector<Row>&)
+	{
+	}
 };
 
-/** Sparse matrix class. */
-class Matrix
+/** Callback using non-member function. */
+class GlobalCallback : public Callback
 {
-	/** Abstract base class for solution callback. */
-	class Callback
+public:
+	typedef void(*function)(const QVector<Row>&);
+
+	/**
+	 * Constructs callback.
+	 *
+	 * @param f non-member function to use as callback
+	 */
+	GlobalCallback(function f) :
+		m_function(f)
 	{
-	public:
-		/** Destroy collback. */
-		virtual ~Callback()
-		{
-		}
-
-		/** Empty function to allow for ignored callbacks. */
-		virtual void operator()(const QVector<Node*>&, unsigned int)
-		{
-		}
-	};
+	}
 
-	/** Callback using non-member function. */
-	class GlobalCallback : public Callback
+	/** Perform callback using non-member function. */
+	void operator()(const QVector<Row>& rows)
 	{
-	public:
-		typedef void(*function)(const QVector<Node*>&);
-
-		/**
-		 * Constructs callback.
-		 *
-		 * @param f non-member function to use as callback
-		 */
-		GlobalCallback(function f) :
-			m_function(f)
-		{
-		}
-
-		/** Perform callback using non-member function. */
-		void operator()(const QVector<Node*>& rows, unsigned int count)
-		{
-			(*m_function)(rows.mid(0, count));
-		}
-
-	private:
-		function m_function; /**< non-member function to use as callback */
-	};
+		(*m_function)(rows);
+	}
 
-	/** Callback using member function */
-	template <typename T>
-	class MemberCallback : public Callback
+private:
+	function m_function; /**< non-member function to use as callback */
+};
+
+/** Callback using member function */
+template <typename T>
+class MemberCallback : public Callback
+{
+public:
+	typedef void(T::*function)(const QVector<Row>& rows);
+
+	/**
+	 * Constructs callback.
+	 *
+	 * @param object pointer to object of callback
+	 * @param f member function of @p object to use as callback
+	 */
+	MemberCallback(T* object, function f) :
+		m_object(object),
+		m_function(f)
+	{
+	}
+
+	/** Perform callback using member function. */
+	void operator()(const QVector<Row>& rows)
+	{
+		(*m_object.*m_function)(rows);
+	}
+
+private:
+	T* m_object; /**< pointer to object of callback */
+	function m_function; /**< member function of @p object to use as callback */
+};
+
+/** Sparse matrix class. */
+class Matrix
+{
+	/** Search state at one depth of Algorithm X. */
+	struct Frame
 	{
-	public:
-		typedef void(T::*function)(const QVector<Node*>& rows);
-
-		/**
-		 * Constructs callback.
-		 *
-		 * @param object pointer to object of callback
-		 * @param f member function of @p object to use as callback
-		 */
-		MemberCallback(T* object, function f) :
-			m_object(object),
-			m_function(f)
-		{
-		}
-
-		/** Perform callback using member function. */
-		void operator()(const QVector<Node*>& rows, unsigned int count)
-		{
-			(*m_object.*m_function)(rows.mid(0, count));
-		}
-
-	private:
-		T* m_object; /**< pointer to object of callback */
-		function m_function; /**< member function of @p object to use as callback */
+		quint32 column; /**< index of column being covered at this depth */
+		quint32 row; /**< index of node of current row in column, or @a column if none chosen yet */
+		quint32 first; /**< index of node of first row to try in column, or @a column if it is empty */
 	};
 
 public:
-	/** Constructs a matrix with @p max_columns number of columns. */
-	Matrix(unsigned int max_columns);
-
-	/** Clean up matrix. */
-	~Matrix();
+	/**
+	 * Constructs a matrix with @p max_columns number of columns.
+	 *
+	 * @param max_columns amount of constraints
+	 * @param max_elements expected amount of elements, used to reserve memory up front
+	 */
+	Matrix(unsigned int max_columns, unsigned int max_elements = 0);
 
 	/** Add row to matrix. */
 	void addRow();
@@ -166,6 +203,34 @@ public:
 	 */
 	void addElement(unsigned int column);
 
+	/**
+	 * Set flag that stops search early when it becomes non-zero.
+	 *
+	 * This allows another thread to cancel a running search.
+	 *
+	 * @param cancelled flag to check before each attempt, or @c nullptr to never stop early
+	 */
+	void setCancelled(const QAtomicInt* cancelled);
+
+	/**
+	 * Set randomized restarts for searches that run out of tries.
+	 *
+	 * The rows of each chosen column are tried starting from a random one,
+	 * and a search that runs out of tries before finding any solution starts
+	 * over on the same matrix. The allowed tries of each restart follow the
+	 * Luby sequence (1, 1, 2, 1, 1, 2, 4, ...) times @a max_tries of search.
+	 *
+	 * @param random random number generator used to choose the first row to try, or @c nullptr to always search in order
+	 * @param max_restarts how many times to restart a search that runs out of tries
+	 */
+	void setRestarts(std::mt19937* random, unsigned int max_restarts);
+
+	/** Returns the work done by matrix since it was constructed. */
+	const Statistics& statistics() const
+	{
+		return m_statistics;
+	}
+
 	/**
 	 * Search for solutions.
 	 *
@@ -187,7 +252,7 @@ public:
 	 * @param max_tries maximum allowed attempts before stopping search
 	 * @return total count of solutions
 	 */
-	unsigned int search(void(*function)(const QVector<Node*>& rows), unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
+	unsigned int search(void(*function)(const QVector<Row>& rows), unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
 	{
 		GlobalCallback solution(function);
 		return search(&solution, max_solutions, max_tries);
@@ -203,7 +268,7 @@ public:
 	 * @return total count of solutions
 	 */
 	template <typename T>
-	unsigned int search(T* object, void(T::*function)(const QVector<Node*>& rows), unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
+	unsigned int search(T* object, void(T::*function)(const QVector<Row>& rows), unsigned int max_solutions = 0xFFFFFFFF, unsigned int max_tries = 0xFFFFFFFF)
 	{
 		MemberCallback<T> solution(object, function);
 		return search(&solution, max_solutions, max_tries);
@@ -221,41 +286,66 @@ private:
 	unsigned int search(Callback* solution, unsigned int max_solutions, unsigned int max_tries);
 
 	/**
-	 * Run Algorithm X at depth @p k.
+	 * Run Algorithm X.
+	 *
+	 * Instead of recursing once per chosen row, this keeps an explicit stack
+	 * of search frames so that the depth of the search is not limited by the
+	 * size of the native call stack. The matrix is fully restored when the
+	 * search ends, even if it was stopped early.
+	 */
+	void solve();
+
+	/**
+	 * Pass the rows of the first @p k search frames to the solution callback.
+	 */
+	void report(unsigned int k);
+
+	/**
+	 * Remove the columns of a row from matrix, except for the column of @p row.
 	 *
-	 * This is a recursive function that hides rows and columns and checks to
-	 * see if a solution has been found.
+	 * @param row index of node in row to remove
 	 */
-	void solve(unsigned int k);
+	void coverRow(quint32 row);
 
 	/**
-	 * Remove column or row from matrix.
+	 * Add the columns of a row back to matrix, except for the column of @p row.
 	 *
-	 * @param node head node of column or row to remove
+	 * @param row index of node in row to add
 	 */
-	void cover(HeaderNode* node);
+	void uncoverRow(quint32 row);
 
 	/**
-	 * Add column or row back to matrix.
+	 * Remove column from matrix.
 	 *
-	 * @param node head node of column or row to add
+	 * @param column index of head node of column to remove
 	 */
-	void uncover(HeaderNode* node);
+	void cover(quint32 column);
+
+	/**
+	 * Add column back to matrix.
+	 *
+	 * @param column index of head node of column to add
+	 */
+	void uncover(quint32 column);
 
 private:
 	unsigned int m_max_columns; /**< amount of constraints */
 
-	HeaderNode* m_header; /**< root element */
-	QVector<HeaderNode> m_columns; /**< constraints */
-	QLinkedList<HeaderNode> m_rows; /**< rows */
-	QLinkedList<Node> m_nodes; /**< row values */
-	QVector<Node*> m_output; /**< rows where columns do not conflict */
+	QVector<Node> m_nodes; /**< root, column headers, and row values */
+	QVector<quint32> m_sizes; /**< how many nodes with value of 1 are in each column */
+	quint32 m_row; /**< index of first node in current row */
+	QVector<Frame> m_stack; /**< search frames; their rows do not conflict */
 
+	const QAtomicInt* m_cancelled; /**< flag to stop search early */
+	std::mt19937* m_random; /**< random number generator used to choose the first row to try */
+	unsigned int m_max_restarts; /**< how many times to restart a search that runs out of tries */
 	Callback* m_solution; /**< function to call when a solution is found */
 	unsigned int m_solutions; /**< how many solutions have been found so far */
 	unsigned int m_max_solutions; /**< maximum allowed solutions */
 	unsigned int m_tries; /**< how many attempts have been made so far */
 	unsigned int m_max_tries; /**< maximum allowed attempts */
+
+	Statistics m_statistics; /**< work done by matrix */
 };
 
 }
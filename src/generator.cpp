@@ -19,138 +19,799 @@
 
 #include "generator.h"
 
-#include "dancing_links.h"
+#include "bit_matrix.h"
+#include "polyomino.h"
 #include "tile.h"
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QRect>
+#include <QRunnable>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+
 #include <algorithm>
 
 //-----------------------------------------------------------------------------
 
+#if (QT_VERSION >= QT_VERSION_CHECK(5,4,0))
+Q_LOGGING_CATEGORY(tetzleGenerator, "tetzle.generator", QtWarningMsg)
+#else
+Q_LOGGING_CATEGORY(tetzleGenerator, "tetzle.generator")
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Boards with more cells than this are solved in strips
+	const int default_strip_threshold = 4096;
+
+	// Boards with more cells than this are tiled without searching
+	const int default_constructive_threshold = 40000;
+
+	// Preferred amount of cells in each strip
+	const int strip_cells = 2048;
+
+	// Long boards with a side this short or shorter are searched with bitboards
+	const int default_bitboard_width = 16;
+
+	// Widest side that fits in the rows of a bitboard
+	const int max_bitboard_width = 64;
+
+	// How many times each attempt restarts its search before giving up
+	const int default_max_restarts = 12;
+
+	// Milliseconds between checks if generating has been cancelled
+	const int cancel_interval = 20;
+
+	// Pieces are made from every orientation of the tetrominoes
+	typedef Polyomino::Tetrominoes PieceShapes;
+
+	QList<int> shuffledIndexes(int count, std::mt19937& random)
+	{
+		QList<int> indexes;
+		for (int i = 0; i < count; ++i) {
+			indexes.append(i);
+		}
+		std::shuffle(indexes.begin(), indexes.end(), random);
+		return indexes;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 namespace
 {
-	struct Shape
+	class Attempt : public QRunnable
 	{
-		Shape(const QPoint& p1, const QPoint& p2, const QPoint& p3, const QPoint& p4);
+	public:
+		Attempt(int columns, int rows, quint32 seed, quint32 index, const Generator::Tuning& tuning);
+
+		void cancel();
+		void setFollowing(const QList<Attempt*>& following);
+		QVector<DLX::Row> solution() const;
+		const DLX::Statistics& statistics() const;
+		qint64 fillTime() const;
+		qint64 searchTime() const;
+
+		void run();
 
-		QPoint cells[4];
-		int width;
-		int height;
+	private:
+		template <typename Shapes, typename T> void fill(T& matrix, std::mt19937& random, int max_tries);
+		void solved(const QVector<DLX::Row>& rows);
+
+	private:
+		int m_columns;
+		int m_rows;
+		bool m_transposed;
+		quint32 m_seed;
+		quint32 m_index;
+		Generator::Tuning m_tuning;
+		QAtomicInt m_cancelled;
+		QList<Attempt*> m_following;
+		QVector<DLX::Row> m_solution;
+		DLX::Statistics m_statistics;
+		qint64 m_fill_time;
+		qint64 m_search_time;
 	};
 
-	Shape::Shape(const QPoint& p1, const QPoint& p2, const QPoint& p3, const QPoint& p4)
-		: width(0),
-		height(0)
+	Attempt::Attempt(int columns, int rows, quint32 seed, quint32 index, const Generator::Tuning& tuning)
+		: m_columns(columns),
+		m_rows(rows),
+		m_transposed(false),
+		m_seed(seed),
+		m_index(index),
+		m_tuning(tuning),
+		m_cancelled(0),
+		m_fill_time(0),
+		m_search_time(0)
+	{
+		setAutoDelete(false);
+	}
+
+	void Attempt::cancel()
+	{
+		m_cancelled.storeRelease(1);
+	}
+
+	void Attempt::setFollowing(const QList<Attempt*>& following)
+	{
+		m_following = following;
+	}
+
+	QVector<DLX::Row> Attempt::solution() const
+	{
+		return m_solution;
+	}
+
+	const DLX::Statistics& Attempt::statistics() const
+	{
+		return m_statistics;
+	}
+
+	qint64 Attempt::fillTime() const
+	{
+		return m_fill_time;
+	}
+
+	qint64 Attempt::searchTime() const
+	{
+		return m_search_time;
+	}
+
+	void Attempt::run()
+	{
+		// Each attempt has its own random number generator derived from the seed
+		std::seed_seq seq{m_seed, m_index};
+		std::mt19937 random(seq);
+
+		// Create matrix and generate solution
+		const int elements = m_columns * m_rows * PieceShapes::count * PieceShapes::size;
+		const int width = std::min(m_columns, m_rows);
+		const bool bitboard = m_tuning.force_bitboard
+			? (width <= max_bitboard_width)
+			: (width <= m_tuning.bitboard_width && std::max(m_columns, m_rows) >= width * 4);
+		if (bitboard) {
+			// Bitboard rows run along the shorter side
+			m_transposed = (m_columns > m_rows);
+			DLX::BitMatrix matrix(width, m_columns * m_rows, elements);
+			fill<PieceShapes>(matrix, random, m_columns * m_rows);
+		} else {
+			DLX::Matrix matrix(m_columns * m_rows, elements);
+			// Short restarts find a tiling sooner than one long search
+			matrix.setRestarts(&random, m_tuning.max_restarts);
+			fill<PieceShapes>(matrix, random, (m_columns * m_rows) / 2);
+		}
+
+		// Later attempts are no longer needed
+		if (!m_solution.isEmpty()) {
+			for (Attempt* attempt : m_following) {
+				attempt->cancel();
+			}
+		}
+	}
+
+	template <typename Shapes, typename T>
+	void Attempt::fill(T& matrix, std::mt19937& random, int max_tries)
+	{
+		QElapsedTimer timer;
+		timer.start();
+
+		matrix.setCancelled(&m_cancelled);
+
+		QList<int> ids;
+		for (int i = 0; i < Shapes::count; ++i) {
+			ids.append(i);
+		}
+
+		QList<int> cells = shuffledIndexes(m_columns * m_rows, random);
+
+		int cell, col, row;
+		for (int i = 0; i < m_columns * m_rows; ++i) {
+			if (m_cancelled.loadAcquire()) {
+				m_statistics = matrix.statistics();
+				m_fill_time = timer.nsecsElapsed();
+				return;
+			}
+
+			cell = cells.at(i);
+			row = cell / m_columns;
+			col = cell - (row * m_columns);
+
+			std::shuffle(ids.begin(), ids.end(), random);
+			for (int i = 0; i < Shapes::count; ++i) {
+				const auto& shape = Shapes::shapes[ids.at(i)];
+				if (shape.width + col < m_columns && shape.height + row < m_rows) {
+					matrix.addRow();
+					for (int i = 0; i < Shapes::size; ++i) {
+						const int x = shape.cells[i].x() + col;
+						const int y = shape.cells[i].y() + row;
+						matrix.addElement(!m_transposed ? (y * m_columns + x) : (x * m_rows + y));
+					}
+				}
+			}
+		}
+
+		m_fill_time = timer.nsecsElapsed();
+		timer.restart();
+		matrix.search(this, &Attempt::solved, 1, max_tries);
+		m_search_time = timer.nsecsElapsed();
+		m_statistics = matrix.statistics();
+	}
+
+	void Attempt::solved(const QVector<DLX::Row>& rows)
+	{
+		m_solution = rows;
+
+		// Convert cells of transposed bitboard back to cells of board
+		if (m_transposed) {
+			for (DLX::Row& row : m_solution) {
+				for (unsigned int& cell : row) {
+					const int x = cell / m_rows;
+					const int y = cell - (x * m_rows);
+					cell = y * m_columns + x;
+				}
+			}
+		}
+	}
+
+	// Waits for attempts in pool, and cancels them once cancelled is set
+	void waitForAttempts(QThreadPool& pool, const QList<Attempt*>& attempts, const QAtomicInt* cancelled)
 	{
-		cells[0] = p1;
-		cells[1] = p2;
-		cells[2] = p3;
-		cells[3] = p4;
-		for (int i = 0; i < 4; ++i) {
-			width = std::max(width, cells[i].x());
-			height = std::max(height, cells[i].y());
+		if (!cancelled) {
+			pool.waitForDone();
+			return;
+		}
+
+		while (!pool.waitForDone(cancel_interval)) {
+			if (cancelled->loadAcquire()) {
+				for (Attempt* attempt : attempts) {
+					if (attempt) {
+						attempt->cancel();
+					}
+				}
+			}
 		}
 	}
+
+	// Adds the work done by attempt to statistics
+	void addStatistics(Generator::Statistics& statistics, const Attempt* attempt)
+	{
+		++statistics.attempts;
+		statistics.matrix += attempt->statistics();
+		statistics.fill_time += attempt->fillTime();
+		statistics.search_time += attempt->searchTime();
+	}
 }
 
 //-----------------------------------------------------------------------------
 
-Generator::Generator(int columns, int rows, std::mt19937& random) :
+namespace
+{
+	// Finds tilings of part of a grid; solutions contain cell ids of the grid
+	class Region
+	{
+	public:
+		Region(int width, const QRect& bounds);
+
+		void addCell(int cell);
+		template <typename Shapes> QVector< QVector<DLX::Row> > tile(std::mt19937& random, unsigned int max_solutions);
+
+	private:
+		void solved(const QVector<DLX::Row>& rows);
+
+	private:
+		int m_width;
+		QRect m_bounds;
+		QVector<int> m_columns;
+		QVector<int> m_cells;
+		QVector< QVector<DLX::Row> > m_solutions;
+	};
+
+	Region::Region(int width, const QRect& bounds)
+		: m_width(width),
+		m_bounds(bounds),
+		m_columns(bounds.width() * bounds.height(), -1)
+	{
+	}
+
+	void Region::addCell(int cell)
+	{
+		int row = cell / m_width;
+		int col = cell - (row * m_width);
+		Q_ASSERT(m_bounds.contains(col, row));
+		m_columns[(row - m_bounds.y()) * m_bounds.width() + (col - m_bounds.x())] = m_cells.count();
+		m_cells.append(cell);
+	}
+
+	template <typename Shapes>
+	QVector< QVector<DLX::Row> > Region::tile(std::mt19937& random, unsigned int max_solutions)
+	{
+		const int area = m_columns.count();
+		const int bounds_width = m_bounds.width();
+
+		// Add every placement that only covers cells of region
+		DLX::Matrix matrix(m_cells.count(), area * Shapes::count * Shapes::size);
+		int columns[Shapes::size];
+		for (int anchor : shuffledIndexes(area, random)) {
+			int row = anchor / bounds_width;
+			int col = anchor - (row * bounds_width);
+			for (int id : shuffledIndexes(Shapes::count, random)) {
+				const auto& shape = Shapes::shapes[id];
+				if (shape.width + col >= bounds_width || shape.height + row >= m_bounds.height()) {
+					continue;
+				}
+
+				bool fits = true;
+				for (int i = 0; i < Shapes::size; ++i) {
+					columns[i] = m_columns.at((shape.cells[i].y() + row) * bounds_width + shape.cells[i].x() + col);
+					if (columns[i] == -1) {
+						fits = false;
+						break;
+					}
+				}
+				if (fits) {
+					matrix.addRow();
+					for (int i = 0; i < Shapes::size; ++i) {
+						matrix.addElement(columns[i]);
+					}
+				}
+			}
+		}
+
+		// Find tilings and convert them back to cells of grid
+		m_solutions.clear();
+		matrix.search(this, &Region::solved, max_solutions);
+		for (QVector<DLX::Row>& rows : m_solutions) {
+			for (DLX::Row& row : rows) {
+				for (unsigned int& cell : row) {
+					cell = m_cells.at(cell);
+				}
+			}
+		}
+		return m_solutions;
+	}
+
+	void Region::solved(const QVector<DLX::Row>& rows)
+	{
+		m_solutions.append(rows);
+	}
+
+	// Replaces the pieces that are completely inside of bounds with a random tiling of the same cells
+	void retile(QVector<DLX::Row>& pieces, QVector<int>& owners, int width, const QRect& bounds, std::mt19937& random)
+	{
+		// Find pieces that are completely inside of window
+		QVector<int> ids;
+		for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+			for (int x = bounds.left(); x <= bounds.right(); ++x) {
+				int id = owners.at(y * width + x);
+				if (ids.contains(id)) {
+					continue;
+				}
+				bool inside = true;
+				for (unsigned int cell : pieces.at(id)) {
+					int cell_y = cell / width;
+					if (!bounds.contains(cell - (cell_y * width), cell_y)) {
+						inside = false;
+						break;
+					}
+				}
+				if (inside) {
+					ids.append(id);
+				}
+			}
+		}
+		if (ids.count() < 2) {
+			return;
+		}
+
+		// Replace them with a random tiling of the same cells
+		Region region(width, bounds);
+		for (int id : ids) {
+			for (unsigned int cell : pieces.at(id)) {
+				region.addCell(cell);
+			}
+		}
+		QVector< QVector<DLX::Row> > tilings = region.tile<PieceShapes>(random, 1);
+		Q_ASSERT(tilings.count() == 1);
+		const QVector<DLX::Row>& tiling = tilings.first();
+		for (int i = 0; i < ids.count(); ++i) {
+			int id = ids.at(i);
+			pieces[id] = tiling.at(i);
+			for (unsigned int cell : tiling.at(i)) {
+				owners[cell] = id;
+			}
+		}
+	}
+
+	// Converts cells of a grid into cells of its transpose, which is columns wide
+	void transposeCells(QVector<DLX::Row>& pieces, int width, int columns)
+	{
+		for (DLX::Row& piece : pieces) {
+			for (unsigned int& cell : piece) {
+				unsigned int y = cell / width;
+				unsigned int x = cell - (y * width);
+				cell = x * columns + y;
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+Generator::Statistics::Statistics() :
+	method(Search),
+	attempts(0),
+	fill_time(0),
+	search_time(0),
+	seam_time(0),
+	total_time(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+Generator::Tuning::Tuning() :
+	strip_threshold(default_strip_threshold),
+	constructive_threshold(default_constructive_threshold),
+	bitboard_width(default_bitboard_width),
+	force_bitboard(false),
+	max_restarts(default_max_restarts)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+Generator::Generator(int columns, int rows, std::mt19937& random, const QAtomicInt* cancelled, const Tuning& tuning) :
 	m_columns(columns),
 	m_rows(rows),
-	m_random(random)
+	m_cancelled(cancelled),
+	m_tuning(tuning)
 {
-	do {
-		m_pieces.clear();
-		solve();
-	} while (m_pieces.isEmpty());
+	QElapsedTimer timer;
+	timer.start();
+
+	if ((m_columns * m_rows > m_tuning.constructive_threshold) && ((m_columns % 4 == 0) || (m_rows % 4 == 0))) {
+		build(random);
+	} else if (m_columns * m_rows > m_tuning.strip_threshold) {
+		split(random);
+	} else {
+		search(random);
+	}
+
+	m_statistics.total_time = timer.nsecsElapsed();
+
+	// Report statistics
+	if (tetzleGenerator().isDebugEnabled()) {
+		const Statistics& s = m_statistics;
+		static const char* const methods[] = { "search", "split", "build" };
+		QStringList shapes;
+		for (int count : s.shapes) {
+			shapes.append(QString::number(count));
+		}
+		qCDebug(tetzleGenerator).nospace() << m_columns << "x" << m_rows
+			<< " method=" << methods[s.method]
+			<< " pieces=" << m_layout.count()
+			<< " attempts=" << s.attempts
+			<< " rows=" << s.matrix.rows
+			<< " nodes=" << s.matrix.nodes
+			<< " covers=" << s.matrix.covers
+			<< " uncovers=" << s.matrix.uncovers
+			<< " backtracks=" << s.matrix.backtracks
+			<< " tries=" << s.matrix.tries << "/" << s.matrix.max_tries
+			<< " restarts=" << s.matrix.restarts
+			<< " fill=" << (s.fill_time / 1000) << "us"
+			<< " search=" << (s.search_time / 1000) << "us"
+			<< " seams=" << (s.seam_time / 1000) << "us"
+			<< " total=" << (s.total_time / 1000) << "us"
+			<< " shapes=" << qPrintable(shapes.join(','));
+	}
 }
 
 //-----------------------------------------------------------------------------
 
-void Generator::solve()
+bool Generator::isCancelled() const
 {
-	QList<Shape> shapes;
-
-	// Add S
-	shapes.append(Shape(QPoint(1,0), QPoint(2,0), QPoint(0,1), QPoint(1,1)));
-	shapes.append(Shape(QPoint(0,0), QPoint(0,1), QPoint(1,1), QPoint(1,2)));
-	// Add Z
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(1,1), QPoint(2,1)));
-	shapes.append(Shape(QPoint(1,0), QPoint(0,1), QPoint(1,1), QPoint(0,2)));
-	// Add O
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(0,1), QPoint(1,1)));
-	// Add T
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(1,1), QPoint(2,0)));
-	shapes.append(Shape(QPoint(1,0), QPoint(0,1), QPoint(1,1), QPoint(1,2)));
-	shapes.append(Shape(QPoint(0,1), QPoint(1,1), QPoint(1,0), QPoint(2,1)));
-	shapes.append(Shape(QPoint(0,0), QPoint(0,1), QPoint(1,1), QPoint(0,2)));
-	// Add J
-	shapes.append(Shape(QPoint(1,0), QPoint(1,1), QPoint(0,2), QPoint(1,2)));
-	shapes.append(Shape(QPoint(0,0), QPoint(0,1), QPoint(1,1), QPoint(2,1)));
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(0,1), QPoint(0,2)));
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(2,0), QPoint(2,1)));
-	// Add L
-	shapes.append(Shape(QPoint(0,0), QPoint(0,1), QPoint(0,2), QPoint(1,2)));
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(2,0), QPoint(0,1)));
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(1,1), QPoint(1,2)));
-	shapes.append(Shape(QPoint(0,1), QPoint(1,1), QPoint(2,0), QPoint(2,1)));
-	// Add I
-	shapes.append(Shape(QPoint(0,0), QPoint(1,0), QPoint(2,0), QPoint(3,0)));
-	shapes.append(Shape(QPoint(0,0), QPoint(0,1), QPoint(0,2), QPoint(0,3)));
-
-	// Create matrix
-	DLX::Matrix matrix(m_columns * m_rows);
-
-	int size = shapes.size();
-	QList<int> ids;
-	for (int i = 0; i < size; ++i) {
-		ids.append(i);
-	}
-
-	QList<int> cells;
-	for (int i = 0; i < m_columns * m_rows; ++i) {
-		cells.append(i);
-	}
-	std::shuffle(cells.begin(), cells.end(), m_random);
-
-	int cell, col, row;
-	for (int i = 0; i < m_columns * m_rows; ++i) {
-		cell = cells.at(i);
-		row = cell / m_columns;
-		col = cell - (row * m_columns);
-
-		std::shuffle(ids.begin(), ids.end(), m_random);
-		for (int i = 0; i < size; ++i) {
-			const Shape& shape = shapes.at(ids.at(i));
-			if (shape.width + col < m_columns && shape.height + row < m_rows) {
-				matrix.addRow();
-				for (int i = 0; i < 4; ++i) {
-					matrix.addElement((shape.cells[i].y() + row) * m_columns + shape.cells[i].x() + col);
+	return m_cancelled && m_cancelled->loadAcquire();
+}
+
+//-----------------------------------------------------------------------------
+
+void Generator::build(std::mt19937& random)
+{
+	m_statistics.method = Build;
+	std::mt19937 build_random(random());
+
+	// Lay blocks out along the side that is a multiple of 4
+	const bool transpose = (m_columns % 4) != 0;
+	const int width = transpose ? m_rows : m_columns;
+	const int height = transpose ? m_columns : m_rows;
+	Q_ASSERT(width % 4 == 0);
+
+	// Find tilings of blocks that are 4 cells wide
+	QVector< QVector< QVector<DLX::Row> > > blocks(5);
+	for (int h = 1; h <= std::min(4, height); ++h) {
+		Region region(4, QRect(0, 0, 4, h));
+		for (int i = 0; i < 4 * h; ++i) {
+			region.addCell(i);
+		}
+		blocks[h] = region.tile<PieceShapes>(build_random, 1000);
+	}
+
+	// Fill board with blocks in bands of random heights
+	QVector<DLX::Row> pieces;
+	pieces.reserve((width * height) / 4);
+	QVector<int> owners(width * height, -1);
+	std::uniform_int_distribution<int> band_height(2, 4);
+	for (int y = 0; y < height;) {
+		int h = height - y;
+		if (h > 4) {
+			do {
+				h = band_height(build_random);
+			} while (h == height - y - 1);
+		}
+
+		const QVector< QVector<DLX::Row> >& tilings = blocks.at(h);
+		std::uniform_int_distribution<int> tiling(0, tilings.count() - 1);
+		for (int x = 0; x < width; x += 4) {
+			for (const DLX::Row& block_piece : tilings.at(tiling(build_random))) {
+				DLX::Row piece;
+				for (unsigned int cell : block_piece) {
+					int cell_y = cell / 4;
+					int cell_x = cell - (cell_y * 4);
+					int board_cell = (y + cell_y) * width + (x + cell_x);
+					owners[board_cell] = pieces.count();
+					piece.append(board_cell);
 				}
+				pieces.append(piece);
 			}
 		}
+
+		y += h;
 	}
 
-	// Generate solution
-	matrix.search(this, &Generator::solution, 1, m_columns * m_rows);
+	// Re-tile random windows so that the block seams disappear
+	QElapsedTimer timer;
+	timer.start();
+	const int window = 5;
+	const int window_width = std::min(window, width);
+	const int window_height = std::min(window, height);
+	std::uniform_int_distribution<int> window_x(0, width - window_width);
+	std::uniform_int_distribution<int> window_y(0, height - window_height);
+	const int moves = (width * height) / 4;
+	for (int move = 0; move < moves; ++move) {
+		if (isCancelled()) {
+			return;
+		}
+		QRect bounds(window_x(build_random), window_y(build_random), window_width, window_height);
+		retile(pieces, owners, width, bounds, build_random);
+	}
+	m_statistics.seam_time = timer.nsecsElapsed();
+
+	// Convert pieces back to board cells
+	if (transpose) {
+		transposeCells(pieces, width, m_columns);
+	}
+	solution(pieces);
 }
 
 //-----------------------------------------------------------------------------
 
-void Generator::solution(const QVector<DLX::Node*>& rows)
+void Generator::split(std::mt19937& random)
 {
+	m_statistics.method = Split;
+	const quint32 seed = random();
+	std::mt19937 seam_random(random());
+
+	// Cut strips across the longer side
+	const bool transpose = m_columns > m_rows;
+	const int width = transpose ? m_rows : m_columns;
+	const int height = transpose ? m_columns : m_rows;
+
+	// Find strip heights; they are multiples of 4 so every strip can be tiled
+	const int thickness = std::max(4, ((strip_cells / width) / 4) * 4);
+	QList<int> strips;
+	int y = 0;
+	while (y + (2 * thickness) <= height) {
+		strips.append(thickness);
+		y += thickness;
+	}
+	strips.append(height - y);
+
+	// Solve strips in parallel, retrying any strips that run out of tries
+	const int count = strips.count();
+	QVector< QVector<DLX::Row> > solutions(count);
+	QThreadPool pool;
+	pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+	for (quint32 round = 0; ; ++round) {
+		QList<Attempt*> attempts;
+		for (int i = 0; i < count; ++i) {
+			Attempt* attempt = nullptr;
+			if (solutions.at(i).isEmpty()) {
+				attempt = new Attempt(width, strips.at(i), seed, round * count + i, m_tuning);
+				pool.start(attempt);
+			}
+			attempts.append(attempt);
+		}
+		waitForAttempts(pool, attempts, m_cancelled);
+
+		bool solved = true;
+		for (int i = 0; i < count; ++i) {
+			Attempt* attempt = attempts.at(i);
+			if (attempt) {
+				solutions[i] = attempt->solution();
+				solved &= !solutions.at(i).isEmpty();
+				addStatistics(m_statistics, attempt);
+			}
+		}
+		qDeleteAll(attempts);
+
+		if (isCancelled()) {
+			return;
+		} else if (solved) {
+			break;
+		}
+	}
+
+	// Combine strips
+	QVector<DLX::Row> pieces;
+	pieces.reserve((width * height) / 4);
+	QVector<int> owners(width * height, -1);
+	y = 0;
+	for (int i = 0; i < count; ++i) {
+		const int offset = y * width;
+		for (const DLX::Row& strip_piece : solutions.at(i)) {
+			DLX::Row piece;
+			for (unsigned int cell : strip_piece) {
+				owners[cell + offset] = pieces.count();
+				piece.append(cell + offset);
+			}
+			pieces.append(piece);
+		}
+		y += strips.at(i);
+	}
+
+	// Re-tile windows that straddle the seams between strips
+	QElapsedTimer timer;
+	timer.start();
+	const int window = 6;
+	const int window_width = std::min(window, width);
+	std::uniform_int_distribution<int> jitter(0, 2);
+	y = 0;
+	for (int i = 0; i < count - 1; ++i) {
+		y += strips.at(i);
+		for (int x = 0; x < width; x += window / 2) {
+			QRect bounds(std::min(x + jitter(seam_random), width - window_width), y - (window / 2) + jitter(seam_random) - 1, window_width, window);
+			bounds &= QRect(0, 0, width, height);
+			retile(pieces, owners, width, bounds, seam_random);
+		}
+	}
+	m_statistics.seam_time = timer.nsecsElapsed();
+
+	// Convert pieces back to board cells
+	if (transpose) {
+		transposeCells(pieces, width, m_columns);
+	}
+	solution(pieces);
+}
+
+//-----------------------------------------------------------------------------
+
+void Generator::search(std::mt19937& random)
+{
+	// Every attempt derives its own generator from one seed, so the result
+	// does not depend on how many attempts run at the same time
+	const quint32 seed = random();
+
+	const int count = std::max(1, QThread::idealThreadCount());
+	QThreadPool pool;
+	pool.setMaxThreadCount(count);
+
+	quint32 index = 0;
+	do {
+		// Race a batch of attempts
+		QList<Attempt*> attempts;
+		for (int i = 0; i < count; ++i) {
+			attempts.append(new Attempt(m_columns, m_rows, seed, index, m_tuning));
+			++index;
+		}
+		for (int i = 0; i < count; ++i) {
+			attempts.at(i)->setFollowing(attempts.mid(i + 1));
+		}
+
+		// Attempts can only be cancelled from pool
+		if ((count > 1) || m_cancelled) {
+			for (Attempt* attempt : attempts) {
+				pool.start(attempt);
+			}
+			waitForAttempts(pool, attempts, m_cancelled);
+		} else {
+			attempts.first()->run();
+		}
+
+		// Use earliest successful attempt so that the seed reproduces the puzzle
+		for (Attempt* attempt : attempts) {
+			QVector<DLX::Row> rows = attempt->solution();
+			if (!rows.isEmpty()) {
+				solution(rows);
+				break;
+			}
+		}
+		for (Attempt* attempt : attempts) {
+			addStatistics(m_statistics, attempt);
+		}
+		qDeleteAll(attempts);
+	} while (m_layout.isEmpty() && !isCancelled());
+}
+
+//-----------------------------------------------------------------------------
+
+void Generator::solution(const QVector<DLX::Row>& rows)
+{
+	m_layout = rows;
+
+	// Count how often each shape is used
+	m_statistics.shapes.fill(0, PieceShapes::count);
+	for (const DLX::Row& row : rows) {
+		const int index = shapeIndex(row, m_columns);
+		if (index != -1) {
+			++m_statistics.shapes[index];
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int Generator::shapeIndex(const DLX::Row& piece, int columns)
+{
+	if (piece.count() != PieceShapes::size) {
+		return -1;
+	}
+
+	int left = columns;
+	int top = -1;
+	for (unsigned int cell : piece) {
+		const int y = cell / columns;
+		left = std::min(left, int(cell) - (y * columns));
+		top = (top == -1) ? y : std::min(top, y);
+	}
+
+	quint64 mask = 0;
+	for (unsigned int cell : piece) {
+		const int y = cell / columns;
+		const int x = cell - (y * columns);
+		if ((x - left >= 8) || (y - top >= 8)) {
+			return -1;
+		}
+		mask |= Polyomino::cell(x - left, y - top);
+	}
+
+	for (int i = 0; i < PieceShapes::count; ++i) {
+		if (PieceShapes::shapes[i].mask == mask) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+QList< QList<Tile*> > Generator::pieces(const QVector<DLX::Row>& layout, int columns, Arena<Tile>& tiles)
+{
+	QList< QList<Tile*> > pieces;
 	QList<Tile*> piece;
-	for (int i = 0; i < rows.count(); ++i) {
+	for (const DLX::Row& row : layout) {
 		piece.clear();
-		DLX::Node* j = rows[i];
-		do {
-			unsigned int r = j->column->id / m_columns;
-			unsigned int c = j->column->id - (r * m_columns);
-			piece.append(new Tile(c, r));
-			j = j->right;
-		} while (j != rows[i]);
-		m_pieces.append(piece);
+		for (unsigned int id : row) {
+			unsigned int r = id / columns;
+			unsigned int c = id - (r * columns);
+			piece.append(tiles.create(c, r));
+		}
+		pieces.append(piece);
 	}
+	return pieces;
 }
 
 //-----------------------------------------------------------------------------
@@ -20,38 +20,95 @@
 #ifndef GENERATOR_H
 #define GENERATOR_H
 
+#include "arena.h"
+#include "dancing_links.h"
+class Tile;
+
+#include <QAtomicInt>
 #include <QList>
+#include <QLoggingCategory>
 #include <QPoint>
 #include <QVector>
-namespace DLX
-{
-	struct Node;
-}
-class Tile;
 
 #include <random>
 
+Q_DECLARE_LOGGING_CATEGORY(tetzleGenerator)
+
 class Generator
 {
 public:
-	Generator(int columns, int rows, std::mt19937& random);
+	enum Method
+	{
+		Search,
+		Split,
+		Build
+	};
+
+	// Describes how a layout was generated; times are in nanoseconds
+	struct Statistics
+	{
+		Statistics();
+
+		Method method;
+		int attempts; // searches started, including cancelled ones
+		DLX::Statistics matrix; // work done by every search
+		qint64 fill_time; // time spent adding rows to matrices, summed over searches
+		qint64 search_time; // time spent searching, summed over searches
+		qint64 seam_time; // time spent re-tiling windows of the board
+		qint64 total_time;
+		QVector<int> shapes; // how many pieces have each shape
+	};
+
+	// Decides which method and solver are used for a board; defaults are tuned for the game
+	struct Tuning
+	{
+		Tuning();
 
-	QList< QList<Tile*> > pieces() const;
+		int strip_threshold; // boards with more cells than this are solved in strips
+		int constructive_threshold; // boards with more cells than this are tiled without searching
+		int bitboard_width; // long boards with a side this short or shorter are searched with bitboards
+		bool force_bitboard; // search every board with a side that fits in a bitboard with bitboards
+		int max_restarts; // how many times each dancing links search restarts before giving up
+	};
+
+	Generator(int columns, int rows, std::mt19937& random, const QAtomicInt* cancelled = nullptr, const Tuning& tuning = Tuning());
+
+	QVector<DLX::Row> layout() const;
+	QList< QList<Tile*> > pieces(Arena<Tile>& tiles) const;
+	const Statistics& statistics() const;
+
+	static QList< QList<Tile*> > pieces(const QVector<DLX::Row>& layout, int columns, Arena<Tile>& tiles);
+	static int shapeIndex(const DLX::Row& piece, int columns);
 
 private:
-	void solve();
-	void solution(const QVector<DLX::Node*>& rows);
+	bool isCancelled() const;
+	void build(std::mt19937& random);
+	void search(std::mt19937& random);
+	void split(std::mt19937& random);
+	void solution(const QVector<DLX::Row>& rows);
 
 private:
 	int m_columns;
 	int m_rows;
-	QList< QList<Tile*> > m_pieces;
-	std::mt19937& m_random;
+	const QAtomicInt* m_cancelled;
+	Tuning m_tuning;
+	QVector<DLX::Row> m_layout;
+	Statistics m_statistics;
 };
 
-inline QList< QList<Tile*> > Generator::pieces() const
+inline QVector<DLX::Row> Generator::layout() const
+{
+	return m_layout;
+}
+
+inline QList< QList<Tile*> > Generator::pieces(Arena<Tile>& tiles) const
+{
+	return pieces(m_layout, m_columns, tiles);
+}
+
+inline const Generator::Statistics& Generator::statistics() const
 {
-	return m_pieces;
+	return m_statistics;
 }
 
 #endif
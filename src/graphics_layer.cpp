@@ -27,6 +27,7 @@
 #include <QGLFormat>
 #endif
 #include <QOpenGLBuffer>
+#include <QOpenGLFunctions_3_3_Core>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLVertexArrayObject>
 
@@ -133,29 +134,35 @@ void GraphicsLayer::setVersion(int version)
 
 //-----------------------------------------------------------------------------
 
-GraphicsLayer::GraphicsLayer() :
+template<typename T>
+BufferData<T>::BufferData() :
 	m_changed(true)
 {
-	// Start with a 1MB vertex buffer
-	m_data.resize(0x100000 / sizeof(Vertex));
-	VertexArray free_region;
-	free_region.end = m_data.count();
-	m_free_regions.append(free_region);
 }
 
 //-----------------------------------------------------------------------------
 
-GraphicsLayer::~GraphicsLayer()
+template<typename T>
+void BufferData<T>::reserve(int size)
 {
+	VertexArray free_region;
+	free_region.start = m_data.count();
+	free_region.end = free_region.start + size;
+	m_data.resize(free_region.end);
+	remove(free_region);
+
+	m_changed = true;
+	m_changed_regions.clear();
 }
 
 //-----------------------------------------------------------------------------
 
-void GraphicsLayer::updateArray(VertexArray& array, const QVector<Vertex>& data)
+template<typename T>
+void BufferData<T>::update(VertexArray& array, const QVector<T>& data)
 {
 	int length = data.count();
 	if (array.length() != length) {
-		removeArray(array);
+		remove(array);
 		array.start = -1;
 		for (int i = 0; i < m_free_regions.count(); ++i) {
 			VertexArray& free_region = m_free_regions[i];
@@ -189,7 +196,8 @@ void GraphicsLayer::updateArray(VertexArray& array, const QVector<Vertex>& data)
 
 //-----------------------------------------------------------------------------
 
-void GraphicsLayer::removeArray(VertexArray& array)
+template<typename T>
+void BufferData<T>::remove(VertexArray& array)
 {
 	if (array.end == 0) {
 		return;
@@ -230,7 +238,8 @@ void GraphicsLayer::removeArray(VertexArray& array)
 
 //-----------------------------------------------------------------------------
 
-void GraphicsLayer::clearChanged()
+template<typename T>
+void BufferData<T>::clearChanged()
 {
 	m_changed_regions.clear();
 	m_changed = false;
@@ -238,26 +247,140 @@ void GraphicsLayer::clearChanged()
 
 //-----------------------------------------------------------------------------
 
-void GraphicsLayer::uploadChanged(QOpenGLBuffer* vertex_buffer)
+template<typename T>
+void BufferData<T>::upload(QOpenGLBuffer* buffer)
 {
 	if (!m_changed_regions.isEmpty()) {
 		for (const VertexArray& region : m_changed_regions) {
-			vertex_buffer->write(region.start * sizeof(Vertex), m_data.constBegin() + region.start, region.length() * sizeof(Vertex));
+			buffer->write(region.start * sizeof(T), m_data.constBegin() + region.start, region.length() * sizeof(T));
 		}
 		m_changed_regions.clear();
 	} else if (m_changed) {
-		GLsizeiptr size = m_data.count() * sizeof(Vertex);
-		vertex_buffer->allocate(size);
-		vertex_buffer->write(0, m_data.constData(), size);
+		GLsizeiptr size = m_data.count() * sizeof(T);
+		buffer->allocate(size);
+		buffer->write(0, m_data.constData(), size);
 		m_changed = false;
 	}
 }
 
 //-----------------------------------------------------------------------------
 
+template class BufferData<Vertex>;
+template class BufferData<TileInstance>;
+
+//-----------------------------------------------------------------------------
+
+GraphicsLayer::GraphicsLayer()
+{
+	// Start with a 1MB vertex buffer
+	m_vertices.reserve(0x100000 / sizeof(Vertex));
+}
+
+//-----------------------------------------------------------------------------
+
+GraphicsLayer::~GraphicsLayer()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::updateArray(VertexArray& array, const QVector<Vertex>& data)
+{
+	m_vertices.update(array, data);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::removeArray(VertexArray& array)
+{
+	m_vertices.remove(array);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::updateArray(VertexArray& array, const QVector<TileInstance>& data)
+{
+	m_instances.update(array, data);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::removeInstances(VertexArray& array)
+{
+	m_instances.remove(array);
+}
+
+//-----------------------------------------------------------------------------
+
+bool GraphicsLayer::hasInstancing() const
+{
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::drawTiles(const VertexArray& array)
+{
+	draw(array);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::drawShadows(const VertexArray& array)
+{
+	draw(array);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::setTileSize(GLfloat size, GLfloat texture_size)
+{
+	Q_UNUSED(size);
+	Q_UNUSED(texture_size);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::clearChanged()
+{
+	m_vertices.clearChanged();
+	m_instances.clearChanged();
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::reserveInstances(int size)
+{
+	m_instances.reserve(size);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::uploadChanged(QOpenGLBuffer* vertex_buffer)
+{
+	m_vertices.upload(vertex_buffer);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer::uploadInstances(QOpenGLBuffer* instance_buffer)
+{
+	m_instances.upload(instance_buffer);
+}
+
+//-----------------------------------------------------------------------------
+
 GraphicsLayer21::GraphicsLayer21(QOpenGLVertexArrayObject* vertex_array) :
+	m_color(Qt::white),
 	m_program(nullptr),
-	m_vertex_array(vertex_array)
+	m_texture_units(0),
+	m_vertex_array(vertex_array),
+	m_instancing(nullptr),
+	m_shadow_program(nullptr),
+	m_instance_array(nullptr),
+	m_instance_buffer(nullptr),
+	m_tile_size(0),
+	m_texture_size(0)
 {
 	initializeOpenGLFunctions();
 
@@ -281,23 +404,59 @@ GraphicsLayer21::GraphicsLayer21(QOpenGLVertexArrayObject* vertex_array) :
 	m_vertex_buffer->bind();
 
 	// Load shaders
-	QOpenGLShaderProgram* program = loadProgram(0);
+	QOpenGLShaderProgram* program = m_programs[0] = loadProgram("textures0.vert", "textures0.frag", 0);
 	program->setAttributeBuffer(Position, GL_FLOAT, offsetof(Vertex, x), 3, sizeof(Vertex));
 	program->enableAttributeArray(Position);
 
-	program = loadProgram(1);
+	program = m_programs[1] = loadProgram("textures1.vert", "textures1.frag", 1);
 	program->setAttributeBuffer(TexCoord0, GL_FLOAT, offsetof(Vertex, s), 2, sizeof(Vertex));
 	program->setAttributeBuffer(Position, GL_FLOAT, offsetof(Vertex, x), 3, sizeof(Vertex));
 	program->enableAttributeArray(Position);
 	program->setUniformValue("texture0", GLuint(0));
 
-	program = loadProgram(2);
+	program = m_programs[2] = loadProgram("textures2.vert", "textures2.frag", 2);
 	program->setAttributeBuffer(TexCoord1, GL_FLOAT, offsetof(Vertex, s2), 2, sizeof(Vertex));
 	program->setAttributeBuffer(TexCoord0, GL_FLOAT, offsetof(Vertex, s), 2, sizeof(Vertex));
 	program->setAttributeBuffer(Position, GL_FLOAT, offsetof(Vertex, x), 3, sizeof(Vertex));
 	program->enableAttributeArray(Position);
 	program->setUniformValue("texture0", GLuint(0));
 	program->setUniformValue("texture1", GLuint(1));
+
+	// Draw tiles as instanced quads when integer attributes and divisors are available
+	if (!m_vertex_array || (shader_version < "330")) {
+		return;
+	}
+	m_instancing = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_3_Core>();
+	if (!m_instancing || !m_instancing->initializeOpenGLFunctions()) {
+		m_instancing = nullptr;
+		return;
+	}
+
+	m_tile_programs[0] = loadProgram("tiles.vert", "textures1.frag", 1);
+	m_tile_programs[0]->setUniformValue("texture0", GLuint(0));
+
+	m_tile_programs[1] = loadProgram("tiles.vert", "textures2.frag", 2);
+	m_tile_programs[1]->setUniformValue("texture0", GLuint(0));
+	m_tile_programs[1]->setUniformValue("texture1", GLuint(1));
+
+	m_shadow_program = loadProgram("shadows.vert", "textures1.frag", 1);
+	m_shadow_program->setUniformValue("texture0", GLuint(0));
+
+	// Create instance buffer object; corners come from gl_VertexID
+	m_instance_buffer = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	m_instance_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	m_instance_buffer->create();
+	reserveInstances(0x100000 / sizeof(TileInstance));
+
+	m_instance_array = new QOpenGLVertexArrayObject;
+	m_instance_array->create();
+	m_instance_array->bind();
+	for (GLuint attribute = InstancePosition; attribute <= InstanceLook; ++attribute) {
+		m_instancing->glEnableVertexAttribArray(attribute);
+		m_instancing->glVertexAttribDivisor(attribute, 1);
+	}
+	m_vertex_array->bind();
+	m_vertex_buffer->bind();
 }
 
 //-----------------------------------------------------------------------------
@@ -308,12 +467,66 @@ GraphicsLayer21::~GraphicsLayer21()
 	for (int i = 0; i < 3; ++i) {
 		delete m_programs[i];
 	}
+	if (m_instancing) {
+		delete m_tile_programs[0];
+		delete m_tile_programs[1];
+		delete m_shadow_program;
+	}
 
-	// Delete vertex buffer object
+	// Delete buffer objects
 	delete m_vertex_buffer;
+	delete m_instance_buffer;
 
-	// Delete vertex array object
+	// Delete vertex array objects
 	delete m_vertex_array;
+	delete m_instance_array;
+}
+
+//-----------------------------------------------------------------------------
+
+bool GraphicsLayer21::hasInstancing() const
+{
+	return m_instancing != nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer21::drawTiles(const VertexArray& array)
+{
+	if (!m_instancing) {
+		draw(array);
+		return;
+	}
+
+	Q_ASSERT(m_texture_units > 0);
+	useProgram(m_tile_programs[m_texture_units - 1], true);
+	drawInstances(array);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer21::drawShadows(const VertexArray& array)
+{
+	if (!m_instancing) {
+		draw(array);
+		return;
+	}
+
+	useProgram(m_shadow_program, true);
+	drawInstances(array);
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer21::setTileSize(GLfloat size, GLfloat texture_size)
+{
+	m_tile_size = size;
+	m_texture_size = texture_size;
+
+	// Force uniforms to be refreshed
+	if (m_instancing) {
+		useProgram(m_programs[m_texture_units], false);
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -336,6 +549,7 @@ void GraphicsLayer21::clear()
 
 void GraphicsLayer21::draw(const VertexArray& array, GLenum mode)
 {
+	useProgram(m_programs[m_texture_units], false);
 	glDrawArrays(mode, array.start, array.length());
 }
 
@@ -370,7 +584,8 @@ void GraphicsLayer21::setClearColor(const QColor& color)
 
 void GraphicsLayer21::setColor(const QColor& color)
 {
-	m_program->setUniformValue(m_color_location, color);
+	m_color = color;
+	m_program->setUniformValue(m_color_location, m_color);
 }
 
 //-----------------------------------------------------------------------------
@@ -401,13 +616,9 @@ void GraphicsLayer21::setTextureUnits(unsigned int units)
 		return;
 	}
 
-	m_program = program;
-	m_program->bind();
-
-	m_color_location = m_program->uniformLocation("color");
-	m_matrix_location = m_program->uniformLocation("matrix");
-	m_program->setUniformValue(m_color_location, Qt::white);
-	m_program->setUniformValue(m_matrix_location, m_matrix);
+	m_texture_units = units;
+	m_color = Qt::white;
+	useProgram(program, false);
 
 	if (units > 1) {
 		m_program->enableAttributeArray(TexCoord1);
@@ -432,16 +643,35 @@ void GraphicsLayer21::setViewport(GLint x, GLint y, GLsizei width, GLsizei heigh
 
 void GraphicsLayer21::uploadData()
 {
+	if (m_instance_buffer) {
+		m_instance_buffer->bind();
+		uploadInstances(m_instance_buffer);
+	}
+
+	m_vertex_buffer->bind();
 	uploadChanged(m_vertex_buffer);
 }
 
 //-----------------------------------------------------------------------------
 
-QOpenGLShaderProgram* GraphicsLayer21::loadProgram(unsigned int index)
+void GraphicsLayer21::drawInstances(const VertexArray& array)
+{
+	// Point attributes at first instance, since base instance requires OpenGL 4.2
+	const quintptr offset = array.start * sizeof(TileInstance);
+	m_instance_buffer->bind();
+	m_instancing->glVertexAttribIPointer(InstancePosition, 2, GL_INT, sizeof(TileInstance), reinterpret_cast<GLvoid*>(offset + offsetof(TileInstance, x)));
+	m_instancing->glVertexAttribIPointer(InstanceCell, 2, GL_UNSIGNED_SHORT, sizeof(TileInstance), reinterpret_cast<GLvoid*>(offset + offsetof(TileInstance, column)));
+	m_instancing->glVertexAttribIPointer(InstanceLook, 2, GL_UNSIGNED_BYTE, sizeof(TileInstance), reinterpret_cast<GLvoid*>(offset + offsetof(TileInstance, rotation)));
+	m_instancing->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, array.length());
+}
+
+//-----------------------------------------------------------------------------
+
+QOpenGLShaderProgram* GraphicsLayer21::loadProgram(const QString& vertex_file, const QString& frag_file, unsigned int units)
 {
 	// Load vertex shader code
 	QString vertex;
-	QFile file(QString(":/shaders/%1/textures%2.vert").arg(shader_version).arg(index));
+	QFile file(QString(":/shaders/%1/%2").arg(shader_version, vertex_file));
 	if (file.open(QFile::ReadOnly)) {
 		vertex = file.readAll();
 		file.close();
@@ -449,7 +679,7 @@ QOpenGLShaderProgram* GraphicsLayer21::loadProgram(unsigned int index)
 
 	// Load fragment shader code
 	QString frag;
-	file.setFileName(QString(":/shaders/%1/textures%2.frag").arg(shader_version).arg(index));
+	file.setFileName(QString(":/shaders/%1/%2").arg(shader_version, frag_file));
 	if (file.open(QFile::ReadOnly)) {
 		frag = file.readAll();
 		file.close();
@@ -462,25 +692,54 @@ QOpenGLShaderProgram* GraphicsLayer21::loadProgram(unsigned int index)
 	}
 
 	// Create program
-	m_programs[index] = new QOpenGLShaderProgram;
-	m_programs[index]->addShaderFromSourceCode(QOpenGLShader::Vertex, vertex);
-	m_programs[index]->addShaderFromSourceCode(QOpenGLShader::Fragment, frag);
+	QOpenGLShaderProgram* program = new QOpenGLShaderProgram;
+	program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertex);
+	program->addShaderFromSourceCode(QOpenGLShader::Fragment, frag);
 
 	// Set attribute locations
 	if (shader_version < "330") {
-		m_programs[index]->bindAttributeLocation("position", Position);
-		if (index > 0) {
-			m_programs[index]->bindAttributeLocation("texcoord0", TexCoord0);
+		program->bindAttributeLocation("position", Position);
+		if (units > 0) {
+			program->bindAttributeLocation("texcoord0", TexCoord0);
 		}
-		if (index > 1) {
-			m_programs[index]->bindAttributeLocation("texcoord1", TexCoord1);
+		if (units > 1) {
+			program->bindAttributeLocation("texcoord1", TexCoord1);
 		}
 	}
 
 	// Link and bind program
-	m_programs[index]->link();
-	m_programs[index]->bind();
-	return m_programs[index];
+	program->link();
+	program->bind();
+	return program;
+}
+
+//-----------------------------------------------------------------------------
+
+void GraphicsLayer21::useProgram(QOpenGLShaderProgram* program, bool instanced)
+{
+	if (m_program == program) {
+		return;
+	}
+
+	m_program = program;
+	m_program->bind();
+	if (m_instance_array) {
+		if (instanced) {
+			m_instance_array->bind();
+		} else {
+			m_vertex_array->bind();
+		}
+	}
+
+	m_color_location = m_program->uniformLocation("color");
+	m_matrix_location = m_program->uniformLocation("matrix");
+	m_program->setUniformValue(m_color_location, m_color);
+	m_program->setUniformValue(m_matrix_location, m_matrix);
+
+	if (instanced) {
+		m_program->setUniformValue("tile_size", m_tile_size);
+		m_program->setUniformValue("texture_size", m_texture_size);
+	}
 }
 
 //-----------------------------------------------------------------------------
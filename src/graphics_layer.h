@@ -20,11 +20,13 @@
 #ifndef GRAPHICS_LAYER_H
 #define GRAPHICS_LAYER_H
 
+#include <QColor>
 #include <QMatrix4x4>
 #include <QOpenGLFunctions>
 #include <QOpenGLFunctions_1_1>
 #include <QOpenGLFunctions_1_3>
 class QOpenGLBuffer;
+class QOpenGLFunctions_3_3_Core;
 class QOpenGLShaderProgram;
 class QOpenGLVertexArrayObject;
 
@@ -50,6 +52,28 @@ struct Vertex
 };
 
 
+// Per-tile data expanded into a quad by the vertex shader
+struct TileInstance
+{
+	GLint x;
+	GLint y;
+
+	GLushort column;
+	GLushort row;
+
+	GLubyte rotation;
+	GLubyte bevel;
+
+	unsigned char pad[2];
+
+	static TileInstance init(GLint x_, GLint y_, GLushort column_, GLushort row_, GLubyte rotation_, GLubyte bevel_)
+	{
+		TileInstance result = { x_, y_, column_, row_, rotation_, bevel_, {0,0} };
+		return result;
+	}
+};
+
+
 struct VertexArray
 {
 	int start;
@@ -68,6 +92,33 @@ struct VertexArray
 };
 
 
+// Regions of a growable client-side copy of a buffer object
+template<typename T>
+class BufferData
+{
+public:
+	BufferData();
+
+	void reserve(int size);
+	void update(VertexArray& array, const QVector<T>& data);
+	void remove(VertexArray& array);
+
+	void clearChanged();
+	void upload(QOpenGLBuffer* buffer);
+
+	const T& at(int index) const
+	{
+		return m_data.at(index);
+	}
+
+private:
+	QVector<T> m_data;
+	QList<VertexArray> m_free_regions;
+	QList<VertexArray> m_changed_regions;
+	bool m_changed;
+};
+
+
 class GraphicsLayer
 {
 public:
@@ -79,6 +130,14 @@ public:
 	void updateArray(VertexArray& array, const QVector<Vertex>& data);
 	void removeArray(VertexArray& array);
 
+	void updateArray(VertexArray& array, const QVector<TileInstance>& data);
+	void removeInstances(VertexArray& array);
+
+	virtual bool hasInstancing() const;
+	virtual void drawTiles(const VertexArray& array);
+	virtual void drawShadows(const VertexArray& array);
+	virtual void setTileSize(GLfloat size, GLfloat texture_size);
+
 	virtual void bindTexture(unsigned int unit, GLuint texture)=0;
 	virtual void clear()=0;
 	virtual void draw(const VertexArray& region, GLenum mode = GL_TRIANGLES)=0;
@@ -98,17 +157,17 @@ protected:
 protected:
 	void clearChanged();
 	void uploadChanged(QOpenGLBuffer* vertex_buffer);
+	void reserveInstances(int size);
+	void uploadInstances(QOpenGLBuffer* instance_buffer);
 
 	const Vertex& at(int index) const
 	{
-		return m_data.at(index);
+		return m_vertices.at(index);
 	}
 
 private:
-	QVector<Vertex> m_data;
-	QList<VertexArray> m_free_regions;
-	QList<VertexArray> m_changed_regions;
-	bool m_changed;
+	BufferData<Vertex> m_vertices;
+	BufferData<TileInstance> m_instances;
 };
 extern GraphicsLayer* graphics_layer;
 
@@ -120,6 +179,11 @@ public:
 	GraphicsLayer21(QOpenGLVertexArrayObject* vertex_array = nullptr);
 	~GraphicsLayer21();
 
+	virtual bool hasInstancing() const;
+	virtual void drawTiles(const VertexArray& array);
+	virtual void drawShadows(const VertexArray& array);
+	virtual void setTileSize(GLfloat size, GLfloat texture_size);
+
 	virtual void bindTexture(unsigned int unit, GLuint texture);
 	virtual void clear();
 	virtual void draw(const VertexArray& array, GLenum mode = GL_TRIANGLES);
@@ -134,7 +198,9 @@ public:
 	virtual void uploadData();
 
 private:
-	QOpenGLShaderProgram* loadProgram(unsigned int index);
+	void drawInstances(const VertexArray& array);
+	QOpenGLShaderProgram* loadProgram(const QString& vertex_file, const QString& frag_file, unsigned int units);
+	void useProgram(QOpenGLShaderProgram* program, bool instanced);
 
 private:
 	enum Attribute
@@ -144,17 +210,34 @@ private:
 		TexCoord1
 	};
 
+	enum InstanceAttribute
+	{
+		InstancePosition = 0,
+		InstanceCell,
+		InstanceLook
+	};
+
 	QMatrix4x4 m_modelview;
 	QMatrix4x4 m_projection;
 	GLfloat m_matrix[4][4];
+	QColor m_color;
 
 	QOpenGLShaderProgram* m_program;
 	QOpenGLShaderProgram* m_programs[3];
+	unsigned int m_texture_units;
 	int m_color_location;
 	int m_matrix_location;
 
 	QOpenGLVertexArrayObject* m_vertex_array;
 	QOpenGLBuffer* m_vertex_buffer;
+
+	QOpenGLFunctions_3_3_Core* m_instancing;
+	QOpenGLShaderProgram* m_tile_programs[2];
+	QOpenGLShaderProgram* m_shadow_program;
+	QOpenGLVertexArrayObject* m_instance_array;
+	QOpenGLBuffer* m_instance_buffer;
+	GLfloat m_tile_size;
+	GLfloat m_texture_size;
 };
 
 
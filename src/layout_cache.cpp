@@ -0,0 +1,285 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "layout_cache.h"
+
+#include "generator.h"
+#include "path.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include <ctime>
+#include <random>
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Most layouts kept in memory and on disk
+	const int max_layouts = 8;
+
+	// Identifies files of cached layouts
+	const quint32 layout_magic = 0x544C4159;
+	const quint32 layout_version = 1;
+
+	// Checks that layout covers every cell exactly once with pieces the generator makes
+	bool isValid(const QVector<DLX::Row>& layout, int columns, int rows)
+	{
+		const unsigned int cells = columns * rows;
+		QVector<bool> covered(cells, false);
+		unsigned int count = 0;
+		for (const DLX::Row& row : layout) {
+			for (unsigned int cell : row) {
+				if ((cell >= cells) || covered.at(cell)) {
+					return false;
+				}
+				covered[cell] = true;
+				++count;
+			}
+
+			// Board counts on every piece having the same amount of tiles
+			if (Generator::shapeIndex(row, columns) == -1) {
+				return false;
+			}
+		}
+		return count == cells;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+LayoutCache::LayoutCache(QObject* parent) :
+	QThread(parent),
+	m_done(false),
+	m_running(false),
+	m_cancelled(0)
+{
+	// Find layouts left over from previous sessions, newest first
+	QFileInfoList files = QDir(Path::layouts()).entryInfoList(QStringList("*.layout"), QDir::Files, QDir::Time);
+	for (const QFileInfo& file : files) {
+		QStringList dimensions = file.baseName().split('x');
+		QSize size = (dimensions.count() == 2) ? QSize(dimensions.at(0).toInt(), dimensions.at(1).toInt()) : QSize();
+		if (size.isEmpty() || (m_layouts.count() >= max_layouts) || (find(size) != -1)) {
+			QFile::remove(file.absoluteFilePath());
+			continue;
+		}
+
+		// Only load layout when it is needed
+		Layout layout = { size, QVector<DLX::Row>() };
+		m_layouts.append(layout);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+LayoutCache::~LayoutCache()
+{
+	// Stop layout that is being generated instead of waiting for it
+	m_mutex.lock();
+	m_done = true;
+	cancelCurrent();
+	m_mutex.unlock();
+	wait();
+}
+
+//-----------------------------------------------------------------------------
+
+void LayoutCache::warm(int columns, int rows)
+{
+	LayoutCache* cache = instance();
+	QSize size(columns, rows);
+
+	QMutexLocker locker(&cache->m_mutex);
+	if (size.isEmpty() || (cache->m_current == size)) {
+		return;
+	}
+
+	// Only the most recently requested layout is worth generating
+	cache->cancelCurrent();
+	if (cache->find(size) != -1) {
+		cache->m_pending = QSize();
+		return;
+	}
+	cache->m_pending = size;
+	if (!cache->m_running) {
+		cache->m_running = true;
+		cache->wait();
+		cache->start(QThread::LowPriority);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<DLX::Row> LayoutCache::take(int columns, int rows)
+{
+	LayoutCache* cache = instance();
+	QSize size(columns, rows);
+
+	QMutexLocker locker(&cache->m_mutex);
+	cache->m_pending = QSize();
+
+	// Wait for layout if it is already being generated, and otherwise stop
+	// generating so that the caller does not compete with it for threads
+	while (cache->m_current == size) {
+		cache->m_generated.wait(&cache->m_mutex);
+	}
+	cache->cancelCurrent();
+
+	int index = cache->find(size);
+	if (index == -1) {
+		return QVector<DLX::Row>();
+	}
+	Layout layout = cache->m_layouts.takeAt(index);
+
+	// Each layout is only used once; file is removed while locked so that
+	// a newer layout of the same size cannot be saved in between
+	if (layout.rows.isEmpty()) {
+		layout.rows = load(size);
+	}
+	QFile::remove(fileName(size));
+	return layout.rows;
+}
+
+//-----------------------------------------------------------------------------
+
+void LayoutCache::run()
+{
+	forever {
+		// Fetch next layout to generate
+		m_mutex.lock();
+		if (m_done || !m_pending.isValid()) {
+			m_running = false;
+			m_mutex.unlock();
+			break;
+		}
+		QSize size = m_pending;
+		m_pending = QSize();
+		m_current = size;
+		m_cancelled.storeRelease(0);
+		m_mutex.unlock();
+
+		// Generate layout
+#ifndef Q_OS_WIN
+		std::random_device rd;
+		std::mt19937 random(rd());
+#else
+		std::mt19937 random(time(0));
+#endif
+		Layout layout = { size, Generator(size.width(), size.height(), random, &m_cancelled).layout() };
+		if (!layout.rows.isEmpty()) {
+			save(size, layout.rows);
+		}
+
+		// Store layout, dropping least recently generated layouts
+		m_mutex.lock();
+		if (!layout.rows.isEmpty()) {
+			m_layouts.prepend(layout);
+			while (m_layouts.count() > max_layouts) {
+				QFile::remove(fileName(m_layouts.takeLast().size));
+			}
+		}
+		m_current = QSize();
+		m_generated.wakeAll();
+		m_mutex.unlock();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+LayoutCache* LayoutCache::instance()
+{
+	static LayoutCache* cache = 0;
+	if (cache == 0) {
+		cache = new LayoutCache(QCoreApplication::instance());
+	}
+	return cache;
+}
+
+//-----------------------------------------------------------------------------
+
+QString LayoutCache::fileName(const QSize& size)
+{
+	return Path::layouts() + QString("%1x%2.layout").arg(size.width()).arg(size.height());
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<DLX::Row> LayoutCache::load(const QSize& size)
+{
+	QFile file(fileName(size));
+	if (!file.open(QFile::ReadOnly)) {
+		return QVector<DLX::Row>();
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_2);
+	quint32 magic, version;
+	qint32 columns, rows;
+	QVector<DLX::Row> layout;
+	stream >> magic >> version >> columns >> rows >> layout;
+	if ((stream.status() != QDataStream::Ok) || (magic != layout_magic) || (version != layout_version) || (QSize(columns, rows) != size) || !isValid(layout, columns, rows)) {
+		// Do not leave broken layout behind to be found again
+		file.remove();
+		return QVector<DLX::Row>();
+	}
+
+	return layout;
+}
+
+//-----------------------------------------------------------------------------
+
+void LayoutCache::save(const QSize& size, const QVector<DLX::Row>& rows)
+{
+	QFile file(fileName(size));
+	if (!file.open(QFile::WriteOnly)) {
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_2);
+	stream << layout_magic << layout_version << qint32(size.width()) << qint32(size.height()) << rows;
+}
+
+//-----------------------------------------------------------------------------
+
+void LayoutCache::cancelCurrent()
+{
+	if (m_current.isValid()) {
+		m_cancelled.storeRelease(1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int LayoutCache::find(const QSize& size) const
+{
+	for (int i = 0; i < m_layouts.count(); ++i) {
+		if (m_layouts.at(i).size == size) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
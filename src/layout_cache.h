@@ -0,0 +1,69 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+#include "dancing_links.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+
+class LayoutCache : public QThread
+{
+	struct Layout
+	{
+		QSize size;
+		QVector<DLX::Row> rows;
+	};
+
+	LayoutCache(QObject* parent = 0);
+public:
+	~LayoutCache();
+
+	static void warm(int columns, int rows);
+	static QVector<DLX::Row> take(int columns, int rows);
+
+protected:
+	virtual void run();
+
+private:
+	static LayoutCache* instance();
+	static QString fileName(const QSize& size);
+	static QVector<DLX::Row> load(const QSize& size);
+	static void save(const QSize& size, const QVector<DLX::Row>& rows);
+	void cancelCurrent();
+	int find(const QSize& size) const;
+
+private:
+	bool m_done;
+	bool m_running;
+	QSize m_pending;
+	QSize m_current;
+	QList<Layout> m_layouts;
+	QAtomicInt m_cancelled;
+	QMutex m_mutex;
+	QWaitCondition m_generated;
+};
+
+#endif
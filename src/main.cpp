@@ -211,6 +211,7 @@ int main(int argc, char** argv)
 	}
 	dir.mkpath(path + "/images/");
 	dir.mkpath(path + "/images/thumbnails/");
+	dir.mkpath(path + "/layouts/");
 
 	// Update settings layout
 	if (settings.value("Version", 0).toInt() < 2) {
@@ -20,7 +20,9 @@
 #include "new_game_tab.h"
 
 #include "add_image.h"
+#include "board.h"
 #include "image_properties_dialog.h"
+#include "layout_cache.h"
 #include "path.h"
 #include "tag_manager.h"
 #include "thumbnail_delegate.h"
@@ -389,9 +391,11 @@ void NewGameTab::imageSelected(QListWidgetItem* item)
 void NewGameTab::pieceCountChanged(int value)
 {
 	if (m_image_size.isValid()) {
-		int side1 = 4 * value;
-		int side2 = std::max(std::lround(side1 * m_ratio), 1L);
-		m_count->setText(tr("%L1 pieces").arg(side1 * side2 / 4));
+		QSize size = Board::puzzleSize(m_image_size, value);
+		m_count->setText(tr("%L1 pieces").arg(size.width() * size.height() / 4));
+
+		// Generate layout while player is choosing
+		LayoutCache::warm(size.width(), size.height());
 	}
 }
 
@@ -116,6 +116,13 @@ QString Path::images()
 
 //-----------------------------------------------------------------------------
 
+QString Path::layouts()
+{
+	return datapath() + "layouts/";
+}
+
+//-----------------------------------------------------------------------------
+
 QString Path::thumbnails()
 {
 	return datapath() + "images/thumbnails/";
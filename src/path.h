@@ -35,6 +35,7 @@ public:
 	static QString save(int game);
 
 	static QString images();
+	static QString layouts();
 	static QString thumbnails();
 	static QString saves();
 };
@@ -27,16 +27,28 @@
 
 //-----------------------------------------------------------------------------
 
+namespace
+{
+	// Divides rounding towards negative infinity
+	int floorDivide(int value, int divisor)
+	{
+		return (value >= 0) ? (value / divisor) : -((divisor - 1 - value) / divisor);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 Piece::Piece(const QPoint& pos, int rotation, const QList<Tile*>& tiles, Board* board)
 	: m_board(board),
+	m_handle(),
 	m_pos(pos),
 	m_tiles(tiles),
 	m_shadow(tiles),
 	m_rotation(0),
 	m_depth(2),
-	m_selected(true),
-	m_changed(false)
+	m_selected(false)
 {
+	m_group = m_board->addPieceGroup(this, m_tiles);
 	updateTiles();
 	updateShadow();
 
@@ -55,31 +67,42 @@ Piece::Piece(const QPoint& pos, int rotation, const QList<Tile*>& tiles, Board*
 		}
 	}
 
-	// Rotate
+	// Rotate, which also places piece on the board
 	rotate(rotation);
-
-	setSelected(false);
 }
 
 //-----------------------------------------------------------------------------
 
 Piece::~Piece()
 {
-	graphics_layer->removeArray(m_tile_array);
-	graphics_layer->removeArray(m_shadow_array);
-
-	qDeleteAll(m_tiles);
+	releaseArrays();
 }
 
 //-----------------------------------------------------------------------------
 
 bool Piece::collidesWith(const Piece* other) const
 {
-	if (m_board->marginRect(boundingRect()).intersects(other->boundingRect())) {
-		return m_collision_region_expanded.intersects(other->m_collision_region);
-	} else {
+	if (!m_board->marginRect(boundingRect()).intersects(other->boundingRect())) {
 		return false;
 	}
+
+	// Tiles collide if they are less than the margin apart, so find which
+	// offsets between tiles of this piece and tiles of other piece collide
+	const int reach = Tile::size + m_board->margin();
+	const QPoint delta = other->m_pos - m_pos;
+	return m_tile_bitmap.intersects(other->m_tile_bitmap,
+		floorDivide(-reach - delta.x(), Tile::size) + 1,
+		-floorDivide(delta.x() - reach, Tile::size) - 1,
+		floorDivide(-reach - delta.y(), Tile::size) + 1,
+		-floorDivide(delta.y() - reach, Tile::size) - 1);
+}
+
+//-----------------------------------------------------------------------------
+
+bool Piece::contains(const QPoint& pos) const
+{
+	QPoint local = pos - m_pos;
+	return m_rect.contains(local) && m_tile_bitmap.testBit(local.x() / Tile::size, local.y() / Tile::size);
 }
 
 //-----------------------------------------------------------------------------
@@ -87,62 +110,30 @@ bool Piece::collidesWith(const Piece* other) const
 QPoint Piece::randomPoint() const
 {
 	Tile* tile = m_tiles.at(m_board->randomInt(m_tiles.count()));
-	return tile->scenePos() + QPoint(m_board->randomInt(Tile::size), m_board->randomInt(Tile::size));
+	return m_pos + tilePos(tile) + QPoint(m_board->randomInt(Tile::size), m_board->randomInt(Tile::size));
 }
 
 //-----------------------------------------------------------------------------
 
 void Piece::attachNeighbors()
 {
-	auto neighbors = m_neighbors;
-	for (Piece* piece : neighbors) {
+	// Neighbors line up if they expect the solved image in the same place
+	const QPoint expected = anchor();
+	QList<Piece*> pieces;
+	for (Piece* piece : findNeighbors()) {
 		if (piece->m_rotation != m_rotation) {
 			continue;
 		}
 
-		Tile* tile = m_tiles.first();
-		Tile* piece_tile = piece->m_tiles.first();
-		QPoint grid_delta = piece_tile->gridPos() - tile->gridPos();
-		for (int i = 0; i < m_rotation; ++i) {
-			QPoint pos = grid_delta;
-			grid_delta.setX( -pos.y() );
-			grid_delta.setY( pos.x() );
-		}
-		QPoint top_left = tile->scenePos() + grid_delta;
-		QPoint delta = top_left - piece_tile->scenePos();
-
+		QPoint delta = expected - piece->anchor();
 		if (delta.manhattanLength() <= m_board->margin()) {
-			piece->moveBy(delta);
-			attach(piece);
-		}
-	}
-}
-
-//-----------------------------------------------------------------------------
-
-void Piece::findNeighbors(const QList<Piece*>& pieces)
-{
-	// Find neighbor tiles
-	static QList<QPoint> deltas = QList<QPoint>() << QPoint(-1,0) << QPoint(1,0) << QPoint(0,-1) << QPoint(0,1);
-	QList<QPoint> tiles;
-	for (Tile* tile : m_shadow) {
-		QPoint pos(tile->column(), tile->row());
-		for (const QPoint& delta : deltas) {
-			QPoint neighbor = pos + delta;
-			if (!containsTile(neighbor.x(), neighbor.y()) && !tiles.contains(neighbor)) {
-				tiles.append(neighbor);
-			}
+			piece->m_pos += delta;
+			pieces.append(piece);
 		}
 	}
 
-	// Find neighbor pieces
-	for (Piece* piece : pieces) {
-		for (const QPoint& tile : tiles) {
-			if (piece->containsTile(tile.x(), tile.y())) {
-				m_neighbors.insert(piece);
-				break;
-			}
-		}
+	if (!pieces.isEmpty()) {
+		attach(pieces);
 	}
 }
 
@@ -175,9 +166,10 @@ void Piece::pushNeighbors(const QPointF& inertia)
 		// Push target until it is clear from current source
 		// We use a binary-search, pushing away if collision, retracting otherwise
 		QPoint orig = target->m_pos;
+		// Moving that far along the longest dimension of direction always clears source
 		QRect united = source_rect.united(target->boundingRect());
 		float min = 0.0f;
-		float max = united.width() * united.height();
+		float max = united.width() + united.height();
 		while (true) {
 			float test = (min + max) / 2.0f;
 			target->m_pos = orig + (test * direction).toPoint();
@@ -191,12 +183,12 @@ void Piece::pushNeighbors(const QPointF& inertia)
 				Q_ASSERT(max - min > 0.01f);
 			}
 		}
-		target->updateVerts();
+		target->updatePosition();
 		Q_ASSERT(min < max);
 		Q_ASSERT(!source->collidesWith(target));
 
-		// Recurse, and keep inertia for stability.
-		target->pushNeighbors(vector);
+		// Settle target later, and keep inertia for stability.
+		m_board->pushPiece(target, vector);
 	}
 }
 
@@ -226,11 +218,8 @@ void Piece::rotate(const QPoint& origin)
 	}
 	m_rect.setRect(0, 0, m_rect.height(), m_rect.width());
 
-	// Rotate tiles 90 degrees counter-clockwise
-	int count = m_tiles.count();
-	for (int i = 0; i < count; ++i) {
-		m_tiles.at(i)->rotate();
-	}
+	// Tiles stay in frame of solved image, so only collision bitmap has to be rotated
+	m_tile_bitmap = m_tile_bitmap.rotated();
 
 	// Track how many rotations have occured
 	m_rotation += 1;
@@ -246,16 +235,158 @@ void Piece::rotate(const QPoint& origin)
 void Piece::setDepth(int depth)
 {
 	m_depth = (depth + 1) * 2;
-	updateVerts();
 }
 
 //-----------------------------------------------------------------------------
 
 void Piece::setSelected(bool selected)
 {
+	const bool changed = (m_selected != selected);
 	m_selected = selected;
-	if (!m_selected && m_changed) {
-		updateCollisionRegions();
+	if (m_selected) {
+		// Selected pieces are not on the board, so they are not looked up
+		// and they are drawn with their own geometry
+		m_board->removeFromPieceGrid(this);
+		if (changed) {
+			updateArrays();
+		}
+	} else {
+		// Resting pieces are drawn by their chunk
+		m_board->updatePieceGrid(this);
+		releaseArrays();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::appendTiles(QVector<Vertex>& verts, const QPoint& offset) const
+{
+	const QPointF* corners = m_board->corners(rotation());
+	const int z = 0;
+
+	for (const Tile* tile : m_tiles) {
+		QPoint pos = offset + tilePos(tile);
+		int x1 = pos.x();
+		int y1 = pos.y();
+		int x2 = x1 + Tile::size;
+		int y2 = y1 + Tile::size;
+
+		float tx = tile->column() * m_board->tileTextureSize();
+		float ty = tile->row() * m_board->tileTextureSize();
+
+		// Bevels are stored unrotated, and each rotation moves one column left in bumpmap
+		float bx1 = tile->bevel().x() - (0.25f * m_rotation);
+		if (bx1 < 0.0f) {
+			bx1 += 1.0f;
+		}
+		float by1 = tile->bevel().y();
+		float bx2 = bx1 + 0.125;
+		float by2 = by1 + 0.125;
+
+		verts.append( Vertex::init(x1,y1,z, tx + corners[0].x(),ty + corners[0].y(), bx1,by1) );
+		verts.append( Vertex::init(x1,y2,z, tx + corners[1].x(),ty + corners[1].y(), bx1,by2) );
+		verts.append( Vertex::init(x2,y1,z, tx + corners[3].x(),ty + corners[3].y(), bx2,by1) );
+		verts.append( Vertex::init(x2,y1,z, tx + corners[3].x(),ty + corners[3].y(), bx2,by1) );
+		verts.append( Vertex::init(x1,y2,z, tx + corners[1].x(),ty + corners[1].y(), bx1,by2) );
+		verts.append( Vertex::init(x2,y2,z, tx + corners[2].x(),ty + corners[2].y(), bx2,by2) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::appendTiles(QVector<TileInstance>& instances, const QPoint& offset) const
+{
+	for (const Tile* tile : m_tiles) {
+		const QPoint pos = offset + tilePos(tile);
+		instances.append( TileInstance::init(pos.x(), pos.y(), tile->column(), tile->row(), m_rotation, tile->bevelIndex()) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::appendRuns(QVector<Vertex>& verts, const QPoint& offset) const
+{
+	// Sort tiles into rows of solved image
+	QVector<const Tile*> tiles;
+	tiles.reserve(m_tiles.count());
+	for (const Tile* tile : m_tiles) {
+		tiles.append(tile);
+	}
+	std::sort(tiles.begin(), tiles.end(), [](const Tile* lhs, const Tile* rhs) {
+		return (lhs->row() < rhs->row()) || ((lhs->row() == rhs->row()) && (lhs->column() < rhs->column()));
+	});
+
+	// Draw each run of adjacent tiles in a row as one quad
+	static const QPoint unit_corners[4] = { QPoint(0,0), QPoint(0,1), QPoint(1,1), QPoint(1,0) };
+	const QSize size(Tile::size, Tile::size);
+	const float ts = m_board->tileTextureSize();
+	const int z = 0;
+	const int count = tiles.count();
+	for (int i = 0; i < count;) {
+		const Tile* first = tiles.at(i);
+		int next = i + 1;
+		while ((next < count)
+				&& (tiles.at(next)->row() == first->row())
+				&& (tiles.at(next)->column() == tiles.at(next - 1)->column() + 1)) {
+			++next;
+		}
+		const int length = next - i;
+		const QRect rect = QRect(tilePos(first), size).united(QRect(tilePos(tiles.at(next - 1)), size)).translated(offset);
+		i = next;
+
+		int x1 = rect.x();
+		int y1 = rect.y();
+		int x2 = x1 + rect.width();
+		int y2 = y1 + rect.height();
+
+		// Corners of run rotate the same way as corners of a tile
+		QPointF corners[4];
+		for (int k = 0; k < 4; ++k) {
+			const QPoint& corner = unit_corners[(k + m_rotation) % 4];
+			corners[k] = QPointF((first->column() + (corner.x() * length)) * ts, (first->row() + corner.y()) * ts);
+		}
+
+		verts.append( Vertex::init(x1,y1,z, corners[0].x(),corners[0].y()) );
+		verts.append( Vertex::init(x1,y2,z, corners[1].x(),corners[1].y()) );
+		verts.append( Vertex::init(x2,y1,z, corners[3].x(),corners[3].y()) );
+		verts.append( Vertex::init(x2,y1,z, corners[3].x(),corners[3].y()) );
+		verts.append( Vertex::init(x1,y2,z, corners[1].x(),corners[1].y()) );
+		verts.append( Vertex::init(x2,y2,z, corners[2].x(),corners[2].y()) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::appendShadow(QVector<Vertex>& verts, const QPoint& offset) const
+{
+	static const int margin = Tile::size / 2;
+	static const int size = Tile::size * 2;
+	const int z = -1;
+
+	for (const Tile* tile : m_shadow) {
+		QPoint pos = offset + tilePos(tile);
+		int x1 = pos.x() - margin;
+		int y1 = pos.y() - margin;
+		int x2 = x1 + size;
+		int y2 = y1 + size;
+
+		verts.append( Vertex::init(x1,y1,z, 0,0) );
+		verts.append( Vertex::init(x1,y2,z, 0,1) );
+		verts.append( Vertex::init(x2,y1,z, 1,0) );
+		verts.append( Vertex::init(x2,y1,z, 1,0) );
+		verts.append( Vertex::init(x1,y2,z, 0,1) );
+		verts.append( Vertex::init(x2,y2,z, 1,1) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::appendShadow(QVector<TileInstance>& instances, const QPoint& offset) const
+{
+	// Shader places shadows below tiles
+	for (const Tile* tile : m_shadow) {
+		const QPoint pos = offset + tilePos(tile);
+		instances.append( TileInstance::init(pos.x(), pos.y(), tile->column(), tile->row(), m_rotation, tile->bevelIndex()) );
 	}
 }
 
@@ -277,70 +408,151 @@ void Piece::save(QXmlStreamWriter& xml) const
 
 //-----------------------------------------------------------------------------
 
-void Piece::attach(Piece* piece)
+void Piece::attach(const QList<Piece*>& pieces)
 {
-	Q_ASSERT(piece != this);
+	for (Piece* piece : pieces) {
+		Q_ASSERT(piece != this);
 
-	// Update position
-	m_pos.setX(std::min(m_pos.x(), piece->m_pos.x()));
-	m_pos.setY(std::min(m_pos.y(), piece->m_pos.y()));
+		// Update position
+		m_pos.setX(std::min(m_pos.x(), piece->m_pos.x()));
+		m_pos.setY(std::min(m_pos.y(), piece->m_pos.y()));
 
-	// Update shadow
-	m_shadow += piece->m_shadow;
-	updateShadow();
+		// Take ownership of tiles
+		m_group = m_board->joinPieceGroups(m_group, piece->m_group, this);
 
-	// Update position of attached tiles
-	int rotation = m_rotation;
-	for (int i = rotation; i < 4; ++i) {
-		rotate();
-		piece->rotate();
+		// All pieces share the frame of solved image, so tiles can be moved across as they are
+		m_shadow += piece->m_shadow;
+		m_tiles += piece->m_tiles;
+		piece->m_tiles.clear();
 	}
-	m_tiles += piece->m_tiles;
-	piece->m_tiles.clear();
+
+	// Rebuild shadow and geometry once for all attached pieces
+	updateShadow();
 	updateTiles();
-	rotate(rotation);
+	updateVerts();
 
-	// Update neighbors
-	m_neighbors += piece->m_neighbors;
-	m_neighbors.remove(piece);
-	m_neighbors.remove(this);
-	for (Piece* neighbor : m_neighbors) {
-		neighbor->m_neighbors.remove(piece);
-		neighbor->m_neighbors.insert(this);
+	// Remove attached pieces
+	for (Piece* piece : pieces) {
+		m_board->removePiece(piece);
 	}
+}
 
-	// Remove attached piece
-	m_board->removePiece(piece);
+//-----------------------------------------------------------------------------
+
+QPoint Piece::anchor() const
+{
+	// Find where top left corner of solved image would be if this piece was in place
+	Tile* tile = m_tiles.first();
+	QPoint offset = tile->gridPos();
+	for (int i = 0; i < m_rotation; ++i) {
+		offset = QPoint(-offset.y(), offset.x());
+	}
+	return m_pos + tilePos(tile) - offset;
 }
 
 //-----------------------------------------------------------------------------
 
-bool Piece::containsTile(int column, int row)
+bool Piece::containsTile(int column, int row) const
 {
-	bool result = false;
-	for (int i = 0; i < m_tiles.count(); ++i) {
-		const Tile* tile = m_tiles.at(i);
-		if (tile->column() == column && tile->row() == row) {
-			result = true;
-			break;
+	return m_board->tileOwner(column, row) == this;
+}
+
+//-----------------------------------------------------------------------------
+
+QSet<Piece*> Piece::findNeighbors() const
+{
+	// Only tiles on the edge of piece can touch other pieces
+	static const QPoint deltas[] = { QPoint(-1,0), QPoint(1,0), QPoint(0,-1), QPoint(0,1) };
+	QSet<Piece*> neighbors;
+	for (Tile* tile : m_shadow) {
+		for (const QPoint& delta : deltas) {
+			Piece* piece = m_board->tileOwner(tile->column() + delta.x(), tile->row() + delta.y());
+			if (piece && (piece != this)) {
+				neighbors.insert(piece);
+			}
 		}
 	}
-	return result;
+	return neighbors;
 }
 
 //-----------------------------------------------------------------------------
 
-void Piece::updateCollisionRegions()
+QPoint Piece::tilePos(const Tile* tile) const
 {
-	m_changed = false;
-	m_collision_region = QRegion();
-	m_collision_region_expanded = QRegion();
-	QRect rect(0,0, Tile::size, Tile::size);
-	for (int i = 0; i < m_tiles.count(); ++i) {
-		rect.moveTo(m_tiles.at(i)->scenePos());
-		m_collision_region += rect;
-		m_collision_region_expanded += m_board->marginRect(rect);
+	// Rotate offset of tile from frame of solved image into frame of piece
+	const QPoint pos = tile->gridPos() - m_origin;
+	const int right = m_rect.width() - Tile::size;
+	const int bottom = m_rect.height() - Tile::size;
+	switch (m_rotation) {
+	case 1:
+		return QPoint(right - pos.y(), pos.x());
+	case 2:
+		return QPoint(right - pos.x(), bottom - pos.y());
+	case 3:
+		return QPoint(pos.y(), bottom - pos.x());
+	default:
+		return pos;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::releaseArrays()
+{
+	if (graphics_layer->hasInstancing()) {
+		graphics_layer->removeInstances(m_tile_array);
+		graphics_layer->removeInstances(m_shadow_array);
+	} else {
+		graphics_layer->removeArray(m_tile_array);
+		graphics_layer->removeArray(m_shadow_array);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::updateArrays()
+{
+	if (graphics_layer->hasInstancing()) {
+		updateInstances();
+		return;
 	}
+
+	QVector<Vertex> verts;
+	verts.reserve(m_tiles.count() * 6);
+	appendTiles(verts, QPoint());
+	graphics_layer->updateArray(m_tile_array, verts);
+
+	verts.clear();
+	verts.reserve(m_shadow.count() * 6);
+	appendShadow(verts, QPoint());
+	graphics_layer->updateArray(m_shadow_array, verts);
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::updateInstances()
+{
+	QVector<TileInstance> instances;
+	instances.reserve(m_tiles.count());
+	appendTiles(instances, QPoint());
+	graphics_layer->updateArray(m_tile_array, instances);
+
+	instances.clear();
+	instances.reserve(m_shadow.count());
+	appendShadow(instances, QPoint());
+	graphics_layer->updateArray(m_shadow_array, instances);
+}
+
+//-----------------------------------------------------------------------------
+
+void Piece::updatePosition()
+{
+	if (!m_selected) {
+		m_board->updatePieceGrid(this);
+	}
+
+	// Update scene rectangle
+	m_board->updateSceneRectangle(this);
 }
 
 //-----------------------------------------------------------------------------
@@ -376,14 +588,18 @@ void Piece::updateTiles()
 		bottom_right.setX( std::max(pos.x() + Tile::size, bottom_right.x()) );
 		bottom_right.setY( std::max(pos.y() + Tile::size, bottom_right.y()) );
 	}
-	m_rect.setRect(0, 0, bottom_right.x() - top_left.x(), bottom_right.y() - top_left.y());
+	m_origin = top_left;
+	if (m_rotation & 1) {
+		m_rect.setRect(0, 0, bottom_right.y() - top_left.y(), bottom_right.x() - top_left.x());
+	} else {
+		m_rect.setRect(0, 0, bottom_right.x() - top_left.x(), bottom_right.y() - top_left.y());
+	}
 
-	// Shift tiles to be inside rectangle
-	Tile* tile;
+	// Mark which tiles are filled for collisions
+	m_tile_bitmap = TileBitmap(m_rect.width() / Tile::size, m_rect.height() / Tile::size);
 	for (int i = 0; i < count; ++i) {
-		tile = m_tiles.at(i);
-		tile->setParent(this);
-		tile->setPos(tile->gridPos() - top_left);
+		pos = tilePos(m_tiles.at(i)) / Tile::size;
+		m_tile_bitmap.setBit(pos.x(), pos.y());
 	}
 }
 
@@ -391,67 +607,11 @@ void Piece::updateTiles()
 
 void Piece::updateVerts()
 {
-	m_changed = true;
-	if (!m_selected) {
-		updateCollisionRegions();
+	// Geometry is relative to piece, so only rotation and shape changes rebuild it
+	if (m_selected) {
+		updateArrays();
 	}
-
-	QVector<Vertex> verts;
-	int z = m_depth;
-
-	// Update tile verts
-	verts.reserve(m_tiles.count() * 6);
-	for (int i = 0; i < m_tiles.count(); ++i) {
-		Tile* tile = m_tiles.at(i);
-
-		QPoint pos = tile->scenePos();
-		int x1 = pos.x();
-		int y1 = pos.y();
-		int x2 = x1 + Tile::size;
-		int y2 = y1 + Tile::size;
-
-		const QPointF* corners = m_board->corners(rotation());
-		float tx = tile->column() * m_board->tileTextureSize();
-		float ty = tile->row() * m_board->tileTextureSize();
-
-		float bx1 = tile->bevel().x();
-		float by1 = tile->bevel().y();
-		float bx2 = bx1 + 0.125;
-		float by2 = by1 + 0.125;
-
-		verts.append( Vertex::init(x1,y1,z, tx + corners[0].x(),ty + corners[0].y(), bx1,by1) );
-		verts.append( Vertex::init(x1,y2,z, tx + corners[1].x(),ty + corners[1].y(), bx1,by2) );
-		verts.append( Vertex::init(x2,y1,z, tx + corners[3].x(),ty + corners[3].y(), bx2,by1) );
-		verts.append( Vertex::init(x2,y1,z, tx + corners[3].x(),ty + corners[3].y(), bx2,by1) );
-		verts.append( Vertex::init(x1,y2,z, tx + corners[1].x(),ty + corners[1].y(), bx1,by2) );
-		verts.append( Vertex::init(x2,y2,z, tx + corners[2].x(),ty + corners[2].y(), bx2,by2) );
-	}
-	graphics_layer->updateArray(m_tile_array, verts);
-
-	// Update shadow verts
-	z--;
-	static const int offset = Tile::size / 2;
-	static const int size = Tile::size * 2;
-	verts.clear();
-	verts.reserve(m_shadow.count() * 6);
-	for (int i = 0; i < m_shadow.count(); ++i) {
-		QPoint pos = m_shadow.at(i)->scenePos();
-		int x1 = pos.x() - offset;
-		int y1 = pos.y() - offset;
-		int x2 = x1 + size;
-		int y2 = y1 + size;
-
-		verts.append( Vertex::init(x1,y1,z, 0,0) );
-		verts.append( Vertex::init(x1,y2,z, 0,1) );
-		verts.append( Vertex::init(x2,y1,z, 1,0) );
-		verts.append( Vertex::init(x2,y1,z, 1,0) );
-		verts.append( Vertex::init(x1,y2,z, 0,1) );
-		verts.append( Vertex::init(x2,y2,z, 1,1) );
-	}
-	graphics_layer->updateArray(m_shadow_array, verts);
-
-	// Update scene rectangle
-	m_board->updateSceneRectangle(this);
+	updatePosition();
 }
 
 //-----------------------------------------------------------------------------
@@ -21,6 +21,8 @@
 #define PIECE_H
 
 #include "graphics_layer.h"
+#include "piece_store.h"
+#include "tile_bitmap.h"
 class Board;
 class Tile;
 
@@ -28,7 +30,6 @@ class Tile;
 #include <QList>
 #include <QPoint>
 #include <QRect>
-#include <QRegion>
 #include <QSet>
 #include <QXmlStreamWriter>
 
@@ -41,40 +42,56 @@ public:
 	bool collidesWith(const Piece* other) const;
 	bool contains(const QPoint& pos) const;
 	QRect boundingRect() const;
+	int depth() const;
+	PieceStore::Handle handle() const;
 	bool isSelected() const;
 	QPoint randomPoint() const;
 	int rotation() const;
 	QPoint scenePos() const;
 
 	void attachNeighbors();
-	void findNeighbors(const QList<Piece*>& pieces);
 	void moveBy(const QPoint& delta);
 	void pushNeighbors(const QPointF& inertia = QPointF());
 	void rotate(int rotations);
 	void rotate(const QPoint& origin = QPoint());
 	void setDepth(int depth);
+	void setHandle(const PieceStore::Handle& handle);
 	void setPosition(const QPoint& pos);
 	void setSelected(bool selected);
 
-	void drawTiles() const;
-	void drawShadow() const;
+	void appendTiles(QVector<Vertex>& verts, const QPoint& offset) const;
+	void appendTiles(QVector<TileInstance>& instances, const QPoint& offset) const;
+	void appendRuns(QVector<Vertex>& verts, const QPoint& offset) const;
+	void appendShadow(QVector<Vertex>& verts, const QPoint& offset) const;
+	void appendShadow(QVector<TileInstance>& instances, const QPoint& offset) const;
+	void drawTiles(const QMatrix4x4& matrix) const;
+	void drawShadow(const QMatrix4x4& matrix) const;
 	void save(QXmlStreamWriter& xml) const;
 
 private:
-	void attach(Piece* piece);
-	bool containsTile(int column, int row);
-	void updateCollisionRegions();
+	void attach(const QList<Piece*>& pieces);
+	QPoint anchor() const;
+	bool containsTile(int column, int row) const;
+	QSet<Piece*> findNeighbors() const;
+	QPoint tilePos(const Tile* tile) const;
+	QMatrix4x4 transform(const QMatrix4x4& matrix) const;
+	void releaseArrays();
+	void updateArrays();
+	void updateInstances();
+	void updatePosition();
 	void updateShadow();
 	void updateTiles();
 	void updateVerts();
 
 private:
 	Board* m_board;
+	PieceStore::Handle m_handle;
 	QPoint m_pos;
+	QPoint m_origin;
 	QRect m_rect;
 	QList<Tile*> m_tiles;
 	QList<Tile*> m_shadow;
-	QSet<Piece*> m_neighbors;
+	int m_group;
 	int m_rotation;
 	int m_depth;
 	bool m_selected;
@@ -82,9 +99,7 @@ private:
 	VertexArray m_tile_array;
 	VertexArray m_shadow_array;
 
-	bool m_changed;
-	QRegion m_collision_region;
-	QRegion m_collision_region_expanded;
+	TileBitmap m_tile_bitmap;
 };
 
 
@@ -93,9 +108,14 @@ inline QRect Piece::boundingRect() const
 	return m_rect.translated(m_pos);
 }
 
-inline bool Piece::contains(const QPoint& pos) const
+inline int Piece::depth() const
 {
-	return m_collision_region.contains(pos);
+	return m_depth;
+}
+
+inline PieceStore::Handle Piece::handle() const
+{
+	return m_handle;
 }
 
 inline bool Piece::isSelected() const
@@ -116,23 +136,37 @@ inline QPoint Piece::scenePos() const
 inline void Piece::moveBy(const QPoint& delta)
 {
 	m_pos += delta;
-	updateVerts();
+	updatePosition();
 }
 
 inline void Piece::setPosition(const QPoint& pos)
 {
 	m_pos = pos;
-	updateVerts();
+	updatePosition();
+}
+
+inline void Piece::setHandle(const PieceStore::Handle& handle)
+{
+	m_handle = handle;
+}
+
+inline void Piece::drawTiles(const QMatrix4x4& matrix) const
+{
+	graphics_layer->setModelview(transform(matrix));
+	graphics_layer->drawTiles(m_tile_array);
 }
 
-inline void Piece::drawTiles() const
+inline void Piece::drawShadow(const QMatrix4x4& matrix) const
 {
-	graphics_layer->draw(m_tile_array);
+	graphics_layer->setModelview(transform(matrix));
+	graphics_layer->drawShadows(m_shadow_array);
 }
 
-inline void Piece::drawShadow() const
+inline QMatrix4x4 Piece::transform(const QMatrix4x4& matrix) const
 {
-	graphics_layer->draw(m_shadow_array);
+	QMatrix4x4 result = matrix;
+	result.translate(m_pos.x(), m_pos.y(), m_depth);
+	return result;
 }
 
 #endif
@@ -0,0 +1,249 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "piece_chunks.h"
+
+#include "piece.h"
+#include "tile.h"
+
+//-----------------------------------------------------------------------------
+
+const int PieceChunks::cell_size = Tile::size * 16;
+
+//-----------------------------------------------------------------------------
+
+PieceChunks::PieceChunks() :
+	m_detailed(true)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::insert(Piece* piece)
+{
+	const quint64 cell = key(piece->boundingRect().center());
+
+	// Piece changed shape or moved within its chunk
+	QHash<Piece*, quint64>::iterator i = m_pieces.find(piece);
+	if (i != m_pieces.end()) {
+		if (i.value() == cell) {
+			markChanged(cell, m_chunks[cell]);
+			return;
+		}
+		remove(piece);
+	}
+	m_pieces.insert(piece, cell);
+
+	Chunk& chunk = m_chunks[cell];
+	chunk.pieces.append(piece);
+	markChanged(cell, chunk);
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::remove(Piece* piece)
+{
+	QHash<Piece*, quint64>::iterator i = m_pieces.find(piece);
+	if (i == m_pieces.end()) {
+		return;
+	}
+	const quint64 cell = i.value();
+	m_pieces.erase(i);
+
+	QHash<quint64, Chunk>::iterator chunk = m_chunks.find(cell);
+	Q_ASSERT(chunk != m_chunks.end());
+
+	// Order of pieces in a chunk does not matter, so fill gap with last piece
+	QVector<Piece*>& pieces = chunk.value().pieces;
+	int index = pieces.indexOf(piece);
+	if (index != -1) {
+		pieces[index] = pieces.last();
+		pieces.removeLast();
+	}
+	if (pieces.isEmpty()) {
+		releaseArrays(chunk.value());
+		m_chunks.erase(chunk);
+	} else {
+		markChanged(cell, chunk.value());
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::clear()
+{
+	for (Chunk& chunk : m_chunks) {
+		releaseArrays(chunk);
+	}
+	m_chunks.clear();
+	m_pieces.clear();
+	m_changed.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool PieceChunks::updateArrays(bool detailed)
+{
+	// Only build geometry for the level of detail that is drawn
+	if (m_detailed != detailed) {
+		m_detailed = detailed;
+		for (QHash<quint64, Chunk>::iterator i = m_chunks.begin(), end = m_chunks.end(); i != end; ++i) {
+			Chunk& chunk = i.value();
+			if (!chunk.changed && (m_detailed ? chunk.tiles_changed : chunk.runs_changed)) {
+				chunk.changed = true;
+				m_changed.append(i.key());
+			}
+		}
+	}
+
+	if (m_changed.isEmpty()) {
+		return false;
+	}
+
+	const int margin = Tile::size / 2;
+	for (quint64 cell : m_changed) {
+		// Skip chunks that were emptied or already rebuilt
+		QHash<quint64, Chunk>::iterator i = m_chunks.find(cell);
+		if ((i == m_chunks.end()) || !i.value().changed) {
+			continue;
+		}
+		Chunk& chunk = i.value();
+		chunk.changed = false;
+
+		// Bounds include shadows so that chunks are not culled while shadows are visible
+		chunk.rect = QRect();
+		for (const Piece* piece : chunk.pieces) {
+			chunk.rect |= piece->boundingRect();
+		}
+		chunk.rect.adjust(-margin, -margin, margin, margin);
+
+		// Resting pieces all share the same depth
+		chunk.depth = chunk.pieces.first()->depth();
+
+		if (!m_detailed) {
+			buildRuns(chunk);
+		} else if (graphics_layer->hasInstancing()) {
+			buildArrays<TileInstance>(chunk);
+		} else {
+			buildArrays<Vertex>(chunk);
+		}
+	}
+	m_changed.clear();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::drawTiles(const QMatrix4x4& matrix, const QRect& viewport) const
+{
+	for (const Chunk& chunk : m_chunks) {
+		if (viewport.intersects(matrix.mapRect(chunk.rect))) {
+			QMatrix4x4 transform = matrix;
+			transform.translate(0, 0, chunk.depth);
+			graphics_layer->setModelview(transform);
+			if (m_detailed) {
+				graphics_layer->drawTiles(chunk.tiles);
+			} else {
+				graphics_layer->draw(chunk.runs);
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::drawShadows(const QMatrix4x4& matrix, const QRect& viewport) const
+{
+	for (const Chunk& chunk : m_chunks) {
+		if (viewport.intersects(matrix.mapRect(chunk.rect))) {
+			QMatrix4x4 transform = matrix;
+			transform.translate(0, 0, chunk.depth);
+			graphics_layer->setModelview(transform);
+			graphics_layer->drawShadows(chunk.shadows);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T>
+void PieceChunks::buildArrays(Chunk& chunk)
+{
+	// Chunk geometry is in scene coordinates
+	QVector<T> tiles;
+	QVector<T> shadows;
+	for (const Piece* piece : chunk.pieces) {
+		piece->appendTiles(tiles, piece->scenePos());
+		piece->appendShadow(shadows, piece->scenePos());
+	}
+	graphics_layer->updateArray(chunk.tiles, tiles);
+	graphics_layer->updateArray(chunk.shadows, shadows);
+	chunk.tiles_changed = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::buildRuns(Chunk& chunk)
+{
+	QVector<Vertex> runs;
+	for (const Piece* piece : chunk.pieces) {
+		piece->appendRuns(runs, piece->scenePos());
+	}
+	graphics_layer->updateArray(chunk.runs, runs);
+	chunk.runs_changed = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::markChanged(quint64 cell, Chunk& chunk)
+{
+	chunk.tiles_changed = true;
+	chunk.runs_changed = true;
+	if (!chunk.changed) {
+		chunk.changed = true;
+		m_changed.append(cell);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceChunks::releaseArrays(Chunk& chunk)
+{
+	if (graphics_layer->hasInstancing()) {
+		graphics_layer->removeInstances(chunk.tiles);
+		graphics_layer->removeInstances(chunk.shadows);
+	} else {
+		graphics_layer->removeArray(chunk.tiles);
+		graphics_layer->removeArray(chunk.shadows);
+	}
+	graphics_layer->removeArray(chunk.runs);
+}
+
+//-----------------------------------------------------------------------------
+
+quint64 PieceChunks::key(const QPoint& pos)
+{
+	// Round towards negative infinity so that cells left of and above origin do not overlap
+	auto cell = [](int value) {
+		return (value >= 0) ? (value / cell_size) : (((value + 1) / cell_size) - 1);
+	};
+	return (quint64(quint32(cell(pos.x()))) << 32) | quint32(cell(pos.y()));
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,82 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PIECE_CHUNKS_H
+#define PIECE_CHUNKS_H
+
+#include "graphics_layer.h"
+class Piece;
+
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+// Batches resting pieces by scene cell so that each cell is drawn with one call
+class PieceChunks
+{
+public:
+	PieceChunks();
+
+	void insert(Piece* piece);
+	void remove(Piece* piece);
+	void clear();
+
+	bool updateArrays(bool detailed);
+	void drawTiles(const QMatrix4x4& matrix, const QRect& viewport) const;
+	void drawShadows(const QMatrix4x4& matrix, const QRect& viewport) const;
+
+	static const int cell_size;
+
+private:
+	struct Chunk
+	{
+		QVector<Piece*> pieces;
+		QRect rect;
+		int depth;
+		bool changed;
+		bool tiles_changed;
+		bool runs_changed;
+
+		VertexArray tiles;
+		VertexArray shadows;
+		VertexArray runs;
+
+		Chunk()
+		:	depth(0),
+			changed(false),
+			tiles_changed(false),
+			runs_changed(false)
+		{
+		}
+	};
+
+	template<typename T> void buildArrays(Chunk& chunk);
+	void buildRuns(Chunk& chunk);
+	void markChanged(quint64 cell, Chunk& chunk);
+	void releaseArrays(Chunk& chunk);
+	static quint64 key(const QPoint& pos);
+
+private:
+	QHash<quint64, Chunk> m_chunks;
+	QHash<Piece*, quint64> m_pieces;
+	QVector<quint64> m_changed;
+	bool m_detailed;
+};
+
+#endif
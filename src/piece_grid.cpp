@@ -0,0 +1,144 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "piece_grid.h"
+
+#include "tile.h"
+
+#include <QSet>
+
+//-----------------------------------------------------------------------------
+
+const int PieceGrid::cell_size = Tile::size * 4;
+
+//-----------------------------------------------------------------------------
+
+void PieceGrid::insert(Piece* piece, const QRect& rect)
+{
+	const QRect range = cells(rect);
+
+	// Only touch cells if piece moved into different ones
+	QHash<Piece*, QRect>::iterator i = m_pieces.find(piece);
+	if (i != m_pieces.end()) {
+		if (i.value() == range) {
+			return;
+		}
+		remove(piece);
+	}
+	m_pieces.insert(piece, range);
+
+	for (int y = range.top(); y <= range.bottom(); ++y) {
+		for (int x = range.left(); x <= range.right(); ++x) {
+			m_cells[key(x, y)].append(piece);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceGrid::remove(Piece* piece)
+{
+	QHash<Piece*, QRect>::iterator i = m_pieces.find(piece);
+	if (i == m_pieces.end()) {
+		return;
+	}
+	const QRect range = i.value();
+	m_pieces.erase(i);
+
+	for (int y = range.top(); y <= range.bottom(); ++y) {
+		for (int x = range.left(); x <= range.right(); ++x) {
+			QHash<quint64, QVector<Piece*>>::iterator cell = m_cells.find(key(x, y));
+			if (cell == m_cells.end()) {
+				continue;
+			}
+
+			// Order of pieces in a cell does not matter, so fill gap with last piece
+			QVector<Piece*>& pieces = cell.value();
+			int index = pieces.indexOf(piece);
+			if (index != -1) {
+				pieces[index] = pieces.last();
+				pieces.removeLast();
+			}
+			if (pieces.isEmpty()) {
+				m_cells.erase(cell);
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceGrid::clear()
+{
+	m_cells.clear();
+	m_pieces.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<Piece*> PieceGrid::find(const QRect& rect) const
+{
+	QVector<Piece*> result;
+	if (rect.isEmpty()) {
+		return result;
+	}
+
+	const QRect range = cells(rect);
+	if ((range.width() == 1) && (range.height() == 1)) {
+		return m_cells.value(key(range.x(), range.y()));
+	}
+
+	// Pieces that cover several cells are only returned once
+	QSet<Piece*> found;
+	for (int y = range.top(); y <= range.bottom(); ++y) {
+		for (int x = range.left(); x <= range.right(); ++x) {
+			QHash<quint64, QVector<Piece*>>::const_iterator cell = m_cells.constFind(key(x, y));
+			if (cell == m_cells.constEnd()) {
+				continue;
+			}
+			for (Piece* piece : cell.value()) {
+				if (!found.contains(piece)) {
+					found.insert(piece);
+					result.append(piece);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+QRect PieceGrid::cells(const QRect& rect) const
+{
+	// Round towards negative infinity so that cells left of and above origin do not overlap
+	auto cell = [](int value) {
+		return (value >= 0) ? (value / cell_size) : (((value + 1) / cell_size) - 1);
+	};
+	return QRect(QPoint(cell(rect.left()), cell(rect.top())), QPoint(cell(rect.right()), cell(rect.bottom())));
+}
+
+//-----------------------------------------------------------------------------
+
+quint64 PieceGrid::key(int x, int y)
+{
+	return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,50 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PIECE_GRID_H
+#define PIECE_GRID_H
+
+class Piece;
+
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+// Uniform grid of scene cells that tracks which pieces overlap each cell
+class PieceGrid
+{
+public:
+	void insert(Piece* piece, const QRect& rect);
+	void remove(Piece* piece);
+	void clear();
+
+	QVector<Piece*> find(const QRect& rect) const;
+
+	static const int cell_size;
+
+private:
+	QRect cells(const QRect& rect) const;
+	static quint64 key(int x, int y);
+
+private:
+	QHash<quint64, QVector<Piece*>> m_cells;
+	QHash<Piece*, QRect> m_pieces;
+};
+
+#endif
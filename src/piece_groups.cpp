@@ -0,0 +1,94 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "piece_groups.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+
+PieceGroups::PieceGroups() :
+	m_count(0),
+	m_largest(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+int PieceGroups::add(int size)
+{
+	int id = m_parents.count();
+	m_parents.append(id);
+	m_sizes.append(size);
+	++m_count;
+	m_largest = std::max(m_largest, size);
+	return id;
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceGroups::clear()
+{
+	m_parents.clear();
+	m_sizes.clear();
+	m_count = 0;
+	m_largest = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int PieceGroups::find(int id) const
+{
+	int root = id;
+	while (m_parents.at(root) != root) {
+		root = m_parents.at(root);
+	}
+
+	// Point everything along the path directly at the root
+	while (m_parents.at(id) != root) {
+		int parent = m_parents.at(id);
+		m_parents[id] = root;
+		id = parent;
+	}
+
+	return root;
+}
+
+//-----------------------------------------------------------------------------
+
+int PieceGroups::join(int first, int second)
+{
+	first = find(first);
+	second = find(second);
+	if (first == second) {
+		return first;
+	}
+
+	// Hang smaller group below larger one to keep paths short
+	if (m_sizes.at(first) < m_sizes.at(second)) {
+		std::swap(first, second);
+	}
+	m_parents[second] = first;
+	m_sizes[first] += m_sizes.at(second);
+	--m_count;
+	m_largest = std::max(m_largest, m_sizes.at(first));
+	return first;
+}
+
+//-----------------------------------------------------------------------------
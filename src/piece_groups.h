@@ -0,0 +1,63 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PIECE_GROUPS_H
+#define PIECE_GROUPS_H
+
+#include <QVector>
+
+// Disjoint sets of the original pieces, used to track which have been joined together
+class PieceGroups
+{
+public:
+	PieceGroups();
+
+	int add(int size);
+	void clear();
+	int find(int id) const;
+	int join(int first, int second);
+
+	int count() const;
+	int largest() const;
+	int size(int id) const;
+
+private:
+	mutable QVector<int> m_parents;
+	QVector<int> m_sizes;
+	int m_count;
+	int m_largest;
+};
+
+
+inline int PieceGroups::count() const
+{
+	return m_count;
+}
+
+inline int PieceGroups::largest() const
+{
+	return m_largest;
+}
+
+inline int PieceGroups::size(int id) const
+{
+	return m_sizes.at(find(id));
+}
+
+#endif
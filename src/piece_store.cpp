@@ -0,0 +1,134 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "piece_store.h"
+
+//-----------------------------------------------------------------------------
+
+PieceStore::Handle PieceStore::insert(Piece* piece, State state)
+{
+	quint32 index;
+	if (!m_free.isEmpty()) {
+		index = m_free.takeLast();
+	} else {
+		index = m_slots.count();
+		Slot slot = { nullptr, 0, Resting, -1 };
+		m_slots.append(slot);
+	}
+
+	// Generation is odd while slot is in use
+	Slot& slot = m_slots[index];
+	slot.piece = piece;
+	++slot.generation;
+	link(index, state);
+
+	Handle handle = { index, slot.generation };
+	return handle;
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceStore::remove(const Handle& handle)
+{
+	if (!isValid(handle)) {
+		return;
+	}
+
+	unlink(handle.index);
+	Slot& slot = m_slots[handle.index];
+	slot.piece = nullptr;
+	++slot.generation;
+	m_free.append(handle.index);
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceStore::clear()
+{
+	m_slots.clear();
+	m_free.clear();
+	for (int i = 0; i < StateCount; ++i) {
+		m_pieces[i].clear();
+		m_positions[i].clear();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+Piece* PieceStore::piece(const Handle& handle) const
+{
+	return isValid(handle) ? m_slots.at(handle.index).piece : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+PieceStore::State PieceStore::state(const Handle& handle) const
+{
+	Q_ASSERT(isValid(handle));
+	return m_slots.at(handle.index).state;
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceStore::setState(const Handle& handle, State state)
+{
+	Q_ASSERT(isValid(handle));
+	if (m_slots.at(handle.index).state == state) {
+		return;
+	}
+	unlink(handle.index);
+	link(handle.index, state);
+}
+
+//-----------------------------------------------------------------------------
+
+bool PieceStore::isValid(const Handle& handle) const
+{
+	return (handle.index < quint32(m_slots.count())) && (m_slots.at(handle.index).generation == handle.generation) && (handle.generation & 1);
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceStore::unlink(quint32 index)
+{
+	const Slot& slot = m_slots.at(index);
+	QVector<Piece*>& pieces = m_pieces[slot.state];
+	QVector<quint32>& positions = m_positions[slot.state];
+
+	// Order inside a state does not matter, so fill gap with last piece
+	const quint32 last = positions.last();
+	pieces[slot.position] = pieces.last();
+	positions[slot.position] = last;
+	m_slots[last].position = slot.position;
+	pieces.removeLast();
+	positions.removeLast();
+}
+
+//-----------------------------------------------------------------------------
+
+void PieceStore::link(quint32 index, State state)
+{
+	Slot& slot = m_slots[index];
+	slot.state = state;
+	slot.position = m_pieces[state].count();
+	m_pieces[state].append(slot.piece);
+	m_positions[state].append(index);
+}
+
+//-----------------------------------------------------------------------------
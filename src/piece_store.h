@@ -0,0 +1,88 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PIECE_STORE_H
+#define PIECE_STORE_H
+
+class Piece;
+
+#include <QVector>
+
+// Slots of pieces on the board, with each piece kept in a dense list for its state
+class PieceStore
+{
+public:
+	enum State
+	{
+		Resting,
+		Selected,
+		Active,
+		StateCount
+	};
+
+	// Reference to a slot that becomes invalid once its piece is removed
+	struct Handle
+	{
+		quint32 index;
+		quint32 generation;
+	};
+
+	Handle insert(Piece* piece, State state = Resting);
+	void remove(const Handle& handle);
+	void clear();
+
+	Piece* piece(const Handle& handle) const;
+	State state(const Handle& handle) const;
+	void setState(const Handle& handle, State state);
+
+	const QVector<Piece*>& pieces(State state) const;
+	int count() const;
+
+private:
+	bool isValid(const Handle& handle) const;
+	void unlink(quint32 index);
+	void link(quint32 index, State state);
+
+private:
+	struct Slot
+	{
+		Piece* piece;
+		quint32 generation;
+		State state;
+		int position;
+	};
+	QVector<Slot> m_slots;
+	QVector<quint32> m_free;
+
+	QVector<Piece*> m_pieces[StateCount];
+	QVector<quint32> m_positions[StateCount];
+};
+
+
+inline const QVector<Piece*>& PieceStore::pieces(State state) const
+{
+	return m_pieces[state];
+}
+
+inline int PieceStore::count() const
+{
+	return m_slots.count() - m_free.count();
+}
+
+#endif
@@ -0,0 +1,242 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef POLYOMINO_H
+#define POLYOMINO_H
+
+#include <QPoint>
+#include <QtGlobal>
+
+/**
+ * Shape tables of polyominoes that are built by the compiler.
+ *
+ * Each shape is stored as a mask of cells in an 8x8 grid, numbered row by
+ * row. A set of shapes is described by the masks of its free polyominoes;
+ * every rotation and reflection of them is generated, moved into the top
+ * left corner of the grid, and only kept if it is not a copy of an earlier
+ * one. Everything is evaluated with @c constexpr functions, so each set is a
+ * static array with a size known at compile time.
+ */
+namespace Polyomino
+{
+
+/** Fixed orientation of a polyomino made of @a Size cells. */
+template <int Size>
+struct Shape
+{
+	quint64 mask; /**< cells of shape in an 8x8 grid */
+	int width; /**< largest horizontal offset of a cell */
+	int height; /**< largest vertical offset of a cell */
+	QPoint cells[Size]; /**< offsets of cells, row by row */
+};
+
+/** Mask of cell at @p x, @p y. */
+constexpr quint64 cell(int x, int y)
+{
+	return Q_UINT64_C(1) << ((y * 8) + x);
+}
+
+/** Check if bit @p i of @p mask is set. */
+constexpr bool hasBit(quint64 mask, int i)
+{
+	return (mask >> i) & 1;
+}
+
+/** Exchange the bits of @p mask selected by @p bits with the bits @p shift above them. */
+constexpr quint64 swapBits(quint64 mask, quint64 bits, int shift)
+{
+	return ((mask >> shift) & bits) | ((mask & bits) << shift);
+}
+
+/** Exchange the bits of @p mask in @p delta with the bits @p shift below them. */
+constexpr quint64 swapDelta(quint64 mask, quint64 delta, int shift)
+{
+	return mask ^ delta ^ (delta >> shift);
+}
+
+/** Mirror cells of @p mask horizontally. */
+constexpr quint64 reflect(quint64 mask)
+{
+	return swapBits(swapBits(swapBits(mask, Q_UINT64_C(0x5555555555555555), 1), Q_UINT64_C(0x3333333333333333), 2), Q_UINT64_C(0x0F0F0F0F0F0F0F0F), 4);
+}
+
+/** Exchange rows and columns of @p mask, using a single step of @p bits and @p shift. */
+constexpr quint64 transposeStep(quint64 mask, quint64 bits, int shift)
+{
+	return swapDelta(mask, bits & (mask ^ (mask << shift)), shift);
+}
+
+/** Exchange rows and columns of @p mask. */
+constexpr quint64 transpose(quint64 mask)
+{
+	return transposeStep(transposeStep(transposeStep(mask, Q_UINT64_C(0x0F0F0F0F00000000), 28), Q_UINT64_C(0x3333000033330000), 14), Q_UINT64_C(0x5500550055005500), 7);
+}
+
+/** Turn cells of @p mask by 90 degrees. */
+constexpr quint64 rotate(quint64 mask)
+{
+	return reflect(transpose(mask));
+}
+
+/** Move cells of @p mask up and left until they touch the top and left edges. */
+constexpr quint64 normalize(quint64 mask)
+{
+	return (mask == 0) ? 0
+		: ((mask & Q_UINT64_C(0xFF)) == 0) ? normalize(mask >> 8)
+		: ((mask & Q_UINT64_C(0x0101010101010101)) == 0) ? normalize(mask >> 1)
+		: mask;
+}
+
+/** Find @p orientation of @p mask; 0-3 are rotations, and 4-7 are rotations of the reflection. */
+constexpr quint64 orient(quint64 mask, int orientation)
+{
+	return (orientation == 0) ? normalize(mask)
+		: (orientation == 4) ? normalize(reflect(mask))
+		: orient(rotate(mask), orientation - 1);
+}
+
+/** Find position of set bit @p n of @p mask, starting at bit @p i. */
+constexpr int findBit(quint64 mask, int n, int i = 0)
+{
+	return !hasBit(mask, i) ? findBit(mask, n, i + 1)
+		: (n == 0) ? i
+		: findBit(mask, n - 1, i + 1);
+}
+
+/** Find larger of @p a and @p b. */
+constexpr int larger(int a, int b)
+{
+	return (a > b) ? a : b;
+}
+
+/** Find largest horizontal offset of cells of @p mask, starting at bit @p i. */
+constexpr int right(quint64 mask, int i = 0)
+{
+	return (i == 64) ? 0 : larger(hasBit(mask, i) ? (i % 8) : 0, right(mask, i + 1));
+}
+
+/** Find largest vertical offset of cells of @p mask. */
+constexpr int bottom(quint64 mask)
+{
+	return (mask >> 8) ? (1 + bottom(mask >> 8)) : 0;
+}
+
+/** List of indexes used to expand arrays. */
+template <int... I>
+struct Indexes
+{
+};
+
+/** Creates Indexes from 0 to @a N - 1. */
+template <int N, int... I>
+struct MakeIndexes : MakeIndexes<N - 1, N - 1, I...>
+{
+};
+
+template <int... I>
+struct MakeIndexes<0, I...>
+{
+	typedef Indexes<I...> type;
+};
+
+/** Build shape from @p mask. */
+template <int Size, int... I>
+constexpr Shape<Size> createShape(quint64 mask, Indexes<I...>)
+{
+	return Shape<Size>{ mask, right(mask), bottom(mask), { QPoint(findBit(mask, I) % 8, findBit(mask, I) / 8)... } };
+}
+
+/** Find mask of free polyomino @p index. */
+template <quint64 First>
+constexpr quint64 base(int)
+{
+	return First;
+}
+
+template <quint64 First, quint64 Second, quint64... Rest>
+constexpr quint64 base(int index)
+{
+	return (index == 0) ? First : base<Second, Rest...>(index - 1);
+}
+
+/** Every orientation of free polyominoes @a Masks, with copies removed. */
+template <quint64... Masks>
+struct Orientations
+{
+	/** Find orientation @p index % 8 of free polyomino @p index / 8. */
+	static constexpr quint64 candidate(int index)
+	{
+		return orient(base<Masks...>(index / 8), index % 8);
+	}
+
+	/** Check that orientation @p index does not match an earlier one of the same polyomino, starting at @p other. */
+	static constexpr bool isUnique(int index, int other = -1)
+	{
+		return (other == -1) ? isUnique(index, (index / 8) * 8)
+			: (other == index) ? true
+			: (candidate(other) == candidate(index)) ? false
+			: isUnique(index, other + 1);
+	}
+
+	/** Count unique orientations, starting at @p index. */
+	static constexpr int count(int index = 0)
+	{
+		return (index == int(sizeof...(Masks) * 8)) ? 0 : ((isUnique(index) ? 1 : 0) + count(index + 1));
+	}
+
+	/** Find unique orientation @p n, starting at @p index. */
+	static constexpr quint64 mask(int n, int index = 0)
+	{
+		return !isUnique(index) ? mask(n, index + 1)
+			: (n == 0) ? candidate(index)
+			: mask(n - 1, index + 1);
+	}
+};
+
+/** Table of every fixed orientation of polyominoes made of @a Size cells. */
+template <int Size, typename Bases, typename I = typename MakeIndexes<Bases::count()>::type>
+struct Set;
+
+template <int Size, typename Bases, int... I>
+struct Set<Size, Bases, Indexes<I...>>
+{
+	static constexpr int size = Size; /**< how many cells are in each shape */
+	static constexpr int count = sizeof...(I); /**< how many shapes are in set */
+	static constexpr Shape<Size> shapes[sizeof...(I)] = {
+		createShape<Size>(Bases::mask(I), typename MakeIndexes<Size>::type())...
+	}; /**< shapes in set */
+};
+
+template <int Size, typename Bases, int... I>
+constexpr Shape<Size> Set<Size, Bases, Indexes<I...>>::shapes[sizeof...(I)];
+
+/** The 5 free tetrominoes, which are the only shapes that pieces start out as. */
+typedef Set<4, Orientations<
+	cell(0,0) | cell(1,0) | cell(2,0) | cell(3,0), // I
+	cell(0,0) | cell(1,0) | cell(0,1) | cell(1,1), // O
+	cell(0,0) | cell(1,0) | cell(2,0) | cell(1,1), // T
+	cell(1,0) | cell(2,0) | cell(0,1) | cell(1,1), // S
+	cell(0,0) | cell(0,1) | cell(0,2) | cell(1,2)  // L
+>> Tetrominoes;
+
+static_assert(Tetrominoes::count == 19, "There are 19 fixed tetrominoes");
+
+}
+
+#endif
@@ -19,16 +19,11 @@
 
 #include "tile.h"
 
-#include "board.h"
-#include "piece.h"
-
 //-----------------------------------------------------------------------------
 
 Tile::Tile(int column, int row)
-	: m_parent(0),
-	m_column(column),
+	: m_column(column),
 	m_row(row),
-	m_pos(column * size, row * size),
 	m_bevel(0),
 	m_bevel_coords(-1,-1)
 {
@@ -36,22 +31,6 @@ Tile::Tile(int column, int row)
 
 //-----------------------------------------------------------------------------
 
-QPoint Tile::scenePos() const
-{
-	return m_pos + m_parent->scenePos();
-}
-
-//-----------------------------------------------------------------------------
-
-void Tile::rotate()
-{
-	qSwap(m_pos.rx(), m_pos.ry());
-	m_pos.setX(-m_pos.x() + m_parent->boundingRect().width() - Tile::size);
-	m_bevel_coords.setX( (m_bevel_coords.x() > 0.1) ? (m_bevel_coords.x() - 0.25) : 0.8125 );
-}
-
-//-----------------------------------------------------------------------------
-
 void Tile::setBevel(int bevel)
 {
 	m_bevel = qBound(0, bevel, 15);
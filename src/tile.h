@@ -23,7 +23,6 @@
 #include <QPoint>
 #include <QRect>
 #include <QXmlStreamWriter>
-class Piece;
 
 class Tile
 {
@@ -31,27 +30,20 @@ public:
 	Tile(int column, int row);
 
 	QPointF bevel() const;
+	int bevelIndex() const;
 	int column() const;
 	int row() const;
-	Piece* parent() const;
-	QPoint pos() const;
 	QPoint gridPos() const;
-	QPoint scenePos() const;
 
-	void rotate();
 	void setBevel(int bevel);
-	void setPos(const QPoint& pos);
-	void setParent(Piece* parent);
 
 	static const int size = 64;
 
 	void save(QXmlStreamWriter& xml) const;
 
 private:
-	Piece* m_parent;
 	int m_column;
 	int m_row;
-	QPoint m_pos;
 	int m_bevel;
 	QPointF m_bevel_coords;
 };
@@ -62,6 +54,11 @@ inline QPointF Tile::bevel() const
 	return m_bevel_coords;
 }
 
+inline int Tile::bevelIndex() const
+{
+	return m_bevel;
+}
+
 inline int Tile::column() const
 {
 	return m_column;
@@ -72,29 +69,9 @@ inline int Tile::row() const
 	return m_row;
 }
 
-inline Piece* Tile::parent() const
-{
-	return m_parent;
-}
-
-inline QPoint Tile::pos() const
-{
-	return m_pos;
-}
-
 inline QPoint Tile::gridPos() const
 {
 	return QPoint(m_column * size, m_row * size);
 }
 
-inline void Tile::setPos(const QPoint& pos)
-{
-	m_pos = pos;
-}
-
-inline void Tile::setParent(Piece* parent)
-{
-	m_parent = parent;
-}
-
 #endif
@@ -0,0 +1,107 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "tile_bitmap.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+
+TileBitmap::TileBitmap(int columns, int rows)
+	: m_columns(columns),
+	m_rows(rows),
+	m_words((columns + 63) / 64),
+	m_bits(m_words * rows, 0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+TileBitmap TileBitmap::rotated() const
+{
+	// Turn 90 degrees counter-clockwise; a bit at column, row has to end up where
+	// Piece::tilePos() places that tile after m_rotation goes up by one
+	TileBitmap result(m_rows, m_columns);
+	for (int row = 0; row < m_rows; ++row) {
+		for (int column = 0; column < m_columns; ++column) {
+			if (testBit(column, row)) {
+				result.setBit(m_rows - 1 - row, column);
+			}
+		}
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+bool TileBitmap::intersects(const TileBitmap& other, int first_column, int last_column, int first_row, int last_row) const
+{
+	// Check if a bit at column, row has a bit of other anywhere from
+	// column + first_column, row + first_row to column + last_column, row + last_row
+	for (int row = 0; row < m_rows; ++row) {
+		const int first = std::max(row + first_row, 0);
+		const int last = std::min(row + last_row, other.m_rows - 1);
+		if (first > last) {
+			continue;
+		}
+
+		const quint64* words = m_bits.constData() + (row * m_words);
+		for (int word = 0; word < m_words; ++word) {
+			if (!words[word]) {
+				continue;
+			}
+
+			// Spread bits of other across the columns that are close enough
+			quint64 near = 0;
+			for (int other_row = first; other_row <= last; ++other_row) {
+				for (int column = first_column; column <= last_column; ++column) {
+					near |= other.bits(other_row, (word * 64) + column);
+				}
+			}
+			if (words[word] & near) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+
+quint64 TileBitmap::bits(int row, int column) const
+{
+	// Find 64 bits of row starting at column, treating bits outside of bitmap as empty
+	if ((column >= m_columns) || (column <= -64)) {
+		return 0;
+	}
+	const quint64* words = m_bits.constData() + (row * m_words);
+	if (column < 0) {
+		return words[0] << -column;
+	}
+
+	const int word = column >> 6;
+	const int shift = column & 63;
+	quint64 result = words[word] >> shift;
+	if (shift && (word + 1 < m_words)) {
+		result |= words[word + 1] << (64 - shift);
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,70 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TILE_BITMAP_H
+#define TILE_BITMAP_H
+
+#include <QVector>
+
+// Grid of bits marking which tiles of a piece are filled; each row is packed into 64-bit words
+class TileBitmap
+{
+public:
+	TileBitmap(int columns = 0, int rows = 0);
+
+	int columns() const;
+	int rows() const;
+	bool testBit(int column, int row) const;
+	void setBit(int column, int row);
+
+	TileBitmap rotated() const;
+	bool intersects(const TileBitmap& other, int first_column, int last_column, int first_row, int last_row) const;
+
+private:
+	quint64 bits(int row, int column) const;
+
+private:
+	int m_columns;
+	int m_rows;
+	int m_words;
+	QVector<quint64> m_bits;
+};
+
+
+inline int TileBitmap::columns() const
+{
+	return m_columns;
+}
+
+inline int TileBitmap::rows() const
+{
+	return m_rows;
+}
+
+inline bool TileBitmap::testBit(int column, int row) const
+{
+	return (m_bits.at(row * m_words + (column >> 6)) >> (column & 63)) & 1;
+}
+
+inline void TileBitmap::setBit(int column, int row)
+{
+	m_bits[row * m_words + (column >> 6)] |= Q_UINT64_C(1) << (column & 63);
+}
+
+#endif
@@ -40,6 +40,8 @@ unix: !macx {
 # Specify program sources
 HEADERS = src/add_image.h \
 	src/appearance_dialog.h \
+	src/arena.h \
+	src/bit_matrix.h \
 	src/board.h \
 	src/choose_game_dialog.h \
 	src/color_button.h \
@@ -47,6 +49,7 @@ HEADERS = src/add_image.h \
 	src/generator.h \
 	src/graphics_layer.h \
 	src/image_properties_dialog.h \
+	src/layout_cache.h \
 	src/locale_dialog.h \
 	src/message.h \
 	src/new_game_tab.h \
@@ -54,7 +57,13 @@ HEADERS = src/add_image.h \
 	src/overview.h \
 	src/path.h \
 	src/piece.h \
+	src/piece_chunks.h \
+	src/piece_grid.h \
+	src/piece_groups.h \
+	src/piece_store.h \
+	src/polyomino.h \
 	src/tile.h \
+	src/tile_bitmap.h \
 	src/tag_manager.h \
 	src/thumbnail_delegate.h \
 	src/thumbnail_loader.h \
@@ -64,6 +73,7 @@ HEADERS = src/add_image.h \
 
 SOURCES = src/add_image.cpp \
 	src/appearance_dialog.cpp \
+	src/bit_matrix.cpp \
 	src/board.cpp \
 	src/choose_game_dialog.cpp \
 	src/color_button.cpp \
@@ -71,6 +81,7 @@ SOURCES = src/add_image.cpp \
 	src/generator.cpp \
 	src/graphics_layer.cpp \
 	src/image_properties_dialog.cpp \
+	src/layout_cache.cpp \
 	src/locale_dialog.cpp \
 	src/main.cpp \
 	src/message.cpp \
@@ -79,7 +90,12 @@ SOURCES = src/add_image.cpp \
 	src/overview.cpp \
 	src/path.cpp \
 	src/piece.cpp \
+	src/piece_chunks.cpp \
+	src/piece_grid.cpp \
+	src/piece_groups.cpp \
+	src/piece_store.cpp \
 	src/tile.cpp \
+	src/tile_bitmap.cpp \
 	src/tag_manager.cpp \
 	src/thumbnail_delegate.cpp \
 	src/thumbnail_loader.cpp \
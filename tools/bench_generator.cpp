@@ -0,0 +1,367 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "bit_matrix.h"
+#include "generator.h"
+#include "polyomino.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSize>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <random>
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Parses comma separated list of numbers, or returns an empty list on error
+	QList<int> parseNumbers(const QString& text)
+	{
+		QList<int> numbers;
+		for (const QString& item : text.split(',')) {
+			bool ok = false;
+			const int number = item.trimmed().toInt(&ok);
+			if (!ok || (number < 0)) {
+				return QList<int>();
+			}
+			numbers.append(number);
+		}
+		return numbers;
+	}
+
+	// Parses comma separated list of board sizes such as 64x64, or returns an empty list on error
+	QList<QSize> parseSizes(const QString& text)
+	{
+		QList<QSize> sizes;
+		for (const QString& item : text.split(',')) {
+			const QStringList dimensions = item.trimmed().split('x');
+			const QSize size = (dimensions.count() == 2) ? QSize(dimensions.at(0).toInt(), dimensions.at(1).toInt()) : QSize();
+			if (size.isEmpty() || ((size.width() * size.height()) % 4 != 0)) {
+				return QList<QSize>();
+			}
+			sizes.append(size);
+		}
+		return sizes;
+	}
+
+	// Checks that layout covers every cell of board exactly once with tetrominoes
+	bool isValid(const QVector<DLX::Row>& layout, const QSize& size)
+	{
+		const unsigned int cells = size.width() * size.height();
+		QVector<bool> covered(cells, false);
+		unsigned int count = 0;
+		for (const DLX::Row& row : layout) {
+			if (Generator::shapeIndex(row, size.width()) == -1) {
+				return false;
+			}
+			for (unsigned int cell : row) {
+				if ((cell >= cells) || covered.at(cell)) {
+					return false;
+				}
+				covered[cell] = true;
+				++count;
+			}
+		}
+		return count == cells;
+	}
+
+	// Cancels a layout that takes longer than a time limit to generate
+	class Timeout : public QThread
+	{
+	public:
+		Timeout(int msecs);
+		~Timeout();
+
+		const QAtomicInt* cancelled() const;
+		bool expired() const;
+
+	protected:
+		void run();
+
+	private:
+		int m_msecs;
+		bool m_finished;
+		QAtomicInt m_cancelled;
+		QMutex m_mutex;
+		QWaitCondition m_finish;
+	};
+
+	Timeout::Timeout(int msecs)
+		: m_msecs(msecs),
+		m_finished(false),
+		m_cancelled(0)
+	{
+		if (m_msecs > 0) {
+			start();
+		}
+	}
+
+	Timeout::~Timeout()
+	{
+		m_mutex.lock();
+		m_finished = true;
+		m_finish.wakeAll();
+		m_mutex.unlock();
+		wait();
+	}
+
+	const QAtomicInt* Timeout::cancelled() const
+	{
+		return &m_cancelled;
+	}
+
+	bool Timeout::expired() const
+	{
+		return m_cancelled.loadAcquire();
+	}
+
+	void Timeout::run()
+	{
+		m_mutex.lock();
+		if (!m_finished) {
+			m_finish.wait(&m_mutex, m_msecs);
+		}
+		if (!m_finished) {
+			m_cancelled.storeRelease(1);
+		}
+		m_mutex.unlock();
+	}
+
+	// Adds every placement of every tetromino to matrix, in a random order like the generator
+	template <typename T>
+	void fillMatrix(T& matrix, const QSize& size, std::mt19937& random)
+	{
+		typedef Polyomino::Tetrominoes Shapes;
+
+		QVector<int> ids;
+		for (int i = 0; i < Shapes::count; ++i) {
+			ids.append(i);
+		}
+
+		QVector<int> cells;
+		for (int i = 0; i < size.width() * size.height(); ++i) {
+			cells.append(i);
+		}
+		std::shuffle(cells.begin(), cells.end(), random);
+
+		for (int cell : cells) {
+			const int row = cell / size.width();
+			const int col = cell - (row * size.width());
+			std::shuffle(ids.begin(), ids.end(), random);
+			for (int id : ids) {
+				const auto& shape = Shapes::shapes[id];
+				if (shape.width + col < size.width() && shape.height + row < size.height()) {
+					matrix.addRow();
+					for (const QPoint& offset : shape.cells) {
+						matrix.addElement((offset.y() + row) * size.width() + offset.x() + col);
+					}
+				}
+			}
+		}
+	}
+
+	// Builds and searches matrix once, and prints the work done as a CSV row
+	template <typename T>
+	void benchMatrix(T& matrix, QElapsedTimer& timer, const QSize& size, quint32 seed, const QString& solver, int timeout, QTextStream& out)
+	{
+		std::mt19937 random(seed);
+		fillMatrix(matrix, size, random);
+		const qint64 build_time = timer.nsecsElapsed();
+
+		// Search with the try budget that the generator had before it was tuned
+		Timeout limit(timeout);
+		matrix.setCancelled(limit.cancelled());
+		timer.restart();
+		const unsigned int solutions = matrix.search(1, size.width() * size.height());
+		const qint64 search_time = timer.nsecsElapsed();
+
+		const DLX::Statistics& s = matrix.statistics();
+		out << size.width() << ',' << size.height() << ',' << seed << ',' << solver << ','
+			<< s.rows << ',' << s.nodes << ',' << s.covers << ',' << s.uncovers << ',' << s.backtracks << ','
+			<< s.tries << ',' << solutions << ',' << int(!solutions && limit.expired()) << ','
+			<< (build_time / 1000) << ',' << (search_time / 1000) << '\n';
+		out.flush();
+	}
+
+	// Times building and searching one matrix of every placement for each board, solver, and seed
+	int benchMatrices(const QList<QSize>& sizes, int seeds, quint32 first_seed, const QStringList& solvers, int timeout)
+	{
+		for (const QSize& size : sizes) {
+			if (solvers.contains("bitboard") && (size.width() > 64)) {
+				QTextStream(stderr) << "Bitboard matrices are at most 64 cells wide.\n";
+				return 1;
+			}
+		}
+
+		// Print one row for each matrix; times are in microseconds
+		QTextStream out(stdout);
+		out << "columns,rows,seed,solver,matrix_rows,nodes,covers,uncovers,backtracks,tries,solutions,timed_out,build_us,search_us\n";
+		for (const QSize& size : sizes) {
+			const int cells = size.width() * size.height();
+			const int elements = cells * Polyomino::Tetrominoes::count * Polyomino::Tetrominoes::size;
+			for (const QString& solver : solvers) {
+				for (int i = 0; i < seeds; ++i) {
+					QElapsedTimer timer;
+					timer.start();
+					if (solver == "bitboard") {
+						DLX::BitMatrix matrix(size.width(), cells, elements);
+						benchMatrix(matrix, timer, size, first_seed + i, solver, timeout, out);
+					} else {
+						DLX::Matrix matrix(cells, elements);
+						benchMatrix(matrix, timer, size, first_seed + i, solver, timeout, out);
+					}
+				}
+			}
+		}
+		return 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	app.setApplicationName("bench_generator");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Generates puzzle layouts and prints their statistics as CSV, one row per layout.\n"
+		"Every combination of the listed sizes, seeds, and tuning values is generated.");
+	parser.addHelpOption();
+	parser.addOption(QCommandLineOption("sizes", "Board sizes to generate.", "list", "16x16,64x64,128x16,256x64,100x100,400x400"));
+	parser.addOption(QCommandLineOption("seeds", "Amount of seeds to generate for each board.", "count", "5"));
+	parser.addOption(QCommandLineOption("first-seed", "Seed of the first layout of each board.", "seed", "1"));
+	parser.addOption(QCommandLineOption("matrix", "Instead of generating layouts, time building and searching one matrix of every placement on the board."));
+	parser.addOption(QCommandLineOption("timeout", "Milliseconds before a layout is cancelled; 0 waits forever.", "msecs", "30000"));
+	parser.addOption(QCommandLineOption("strip-threshold", "Boards with more cells are solved in strips.", "list", QString::number(Generator::Tuning().strip_threshold)));
+	parser.addOption(QCommandLineOption("constructive-threshold", "Boards with more cells are tiled without searching.", "list", QString::number(Generator::Tuning().constructive_threshold)));
+	parser.addOption(QCommandLineOption("bitboard-width", "Long boards with a side this short are searched with bitboards; 0 always uses dancing links.", "list", QString::number(Generator::Tuning().bitboard_width)));
+	parser.addOption(QCommandLineOption("solver", "Solvers of searched boards: auto picks by shape, dlx always uses dancing links, and bitboard uses bitboards whenever a side is at most 64 cells.", "list", "auto"));
+	parser.addOption(QCommandLineOption("restarts", "Restarts of each dancing links search; 0 turns them off.", "list", QString::number(Generator::Tuning().max_restarts)));
+	parser.process(app);
+
+	QTextStream err(stderr);
+	const QList<QSize> sizes = parseSizes(parser.value("sizes"));
+	if (sizes.isEmpty()) {
+		err << "Board sizes must be listed as WIDTHxHEIGHT with a multiple of 4 cells.\n";
+		return 1;
+	}
+	bool seeds_ok = false;
+	bool first_seed_ok = false;
+	const int seeds = parser.value("seeds").toInt(&seeds_ok);
+	const quint32 first_seed = parser.value("first-seed").toUInt(&first_seed_ok);
+	if (!seeds_ok || !first_seed_ok || (seeds < 1)) {
+		err << "Seeds must be positive numbers.\n";
+		return 1;
+	}
+	bool timeout_ok = false;
+	const int timeout = parser.value("timeout").toInt(&timeout_ok);
+	if (!timeout_ok || (timeout < 0)) {
+		err << "Timeout must be 0 or greater.\n";
+		return 1;
+	}
+	const QList<int> strip_thresholds = parseNumbers(parser.value("strip-threshold"));
+	const QList<int> constructive_thresholds = parseNumbers(parser.value("constructive-threshold"));
+	const QList<int> bitboard_widths = parseNumbers(parser.value("bitboard-width"));
+	const QList<int> restarts = parseNumbers(parser.value("restarts"));
+	if (strip_thresholds.isEmpty() || constructive_thresholds.isEmpty() || bitboard_widths.isEmpty() || restarts.isEmpty()) {
+		err << "Tuning values must be lists of numbers that are 0 or greater.\n";
+		return 1;
+	}
+	const QStringList solvers = parser.value("solver").split(',');
+	for (const QString& solver : solvers) {
+		if ((solver != "auto") && (solver != "dlx") && (solver != "bitboard")) {
+			err << "Solvers must be auto, dlx, or bitboard.\n";
+			return 1;
+		}
+	}
+
+	// Time matrices on their own if requested
+	if (parser.isSet("matrix")) {
+		return benchMatrices(sizes, seeds, first_seed, solvers, timeout);
+	}
+
+	// Find every combination of tuning values; only the automatic solver depends on bitboard width
+	QList<Generator::Tuning> tunings;
+	for (const QString& solver : solvers) {
+		const QList<int> widths = (solver == "auto") ? bitboard_widths : QList<int>() << ((solver == "dlx") ? 0 : bitboard_widths.first());
+		for (int strip_threshold : strip_thresholds) {
+			for (int constructive_threshold : constructive_thresholds) {
+				for (int bitboard_width : widths) {
+					for (int max_restarts : restarts) {
+						Generator::Tuning tuning;
+						tuning.strip_threshold = strip_threshold;
+						tuning.constructive_threshold = constructive_threshold;
+						tuning.bitboard_width = bitboard_width;
+						tuning.force_bitboard = (solver == "bitboard");
+						tuning.max_restarts = max_restarts;
+						tunings.append(tuning);
+					}
+				}
+			}
+		}
+	}
+
+	// Print one row for each layout; times are in microseconds
+	QTextStream out(stdout);
+	out << "columns,rows,seed,solver,strip_threshold,constructive_threshold,bitboard_width,max_restarts,"
+		<< "method,timed_out,pieces,valid,attempts,matrix_rows,nodes,covers,uncovers,backtracks,tries,max_tries,restarts,solutions,"
+		<< "fill_us,search_us,seam_us,total_us,shapes\n";
+	static const char* const methods[] = { "search", "split", "build" };
+	for (const QSize& size : sizes) {
+		for (const Generator::Tuning& tuning : tunings) {
+			for (int i = 0; i < seeds; ++i) {
+				const quint32 seed = first_seed + i;
+				std::mt19937 random(seed);
+				Timeout limit(timeout);
+				Generator generator(size.width(), size.height(), random, limit.cancelled(), tuning);
+				const QVector<DLX::Row> layout = generator.layout();
+
+				const Generator::Statistics& s = generator.statistics();
+				QStringList shapes;
+				for (int count : s.shapes) {
+					shapes.append(QString::number(count));
+				}
+
+				const char* solver = tuning.force_bitboard ? "bitboard" : ((tuning.bitboard_width == 0) ? "dlx" : "auto");
+				out << size.width() << ',' << size.height() << ',' << seed << ',' << solver << ','
+					<< tuning.strip_threshold << ',' << tuning.constructive_threshold << ','
+					<< tuning.bitboard_width << ',' << tuning.max_restarts << ','
+					<< methods[s.method] << ',' << int(layout.isEmpty() && limit.expired()) << ',' << layout.count() << ',' << int(isValid(layout, size)) << ','
+					<< s.attempts << ',' << s.matrix.rows << ',' << s.matrix.nodes << ','
+					<< s.matrix.covers << ',' << s.matrix.uncovers << ',' << s.matrix.backtracks << ','
+					<< s.matrix.tries << ',' << s.matrix.max_tries << ',' << s.matrix.restarts << ',' << s.matrix.solutions << ','
+					<< (s.fill_time / 1000) << ',' << (s.search_time / 1000) << ','
+					<< (s.seam_time / 1000) << ',' << (s.total_time / 1000) << ','
+					<< shapes.join(';') << '\n';
+				out.flush();
+			}
+		}
+	}
+
+	return 0;
+}
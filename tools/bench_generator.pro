@@ -0,0 +1,45 @@
+# Benchmark of the puzzle generator; prints statistics of generated layouts as CSV
+#
+# Build with 'qmake tools/bench_generator.pro && make', and then run
+# './bench_generator --help' to see which boards and tuning values it sweeps.
+
+lessThan(QT_MAJOR_VERSION, 5) {
+	error("Tetzle requires Qt 5.2 or greater")
+}
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 2) {
+	error("Tetzle requires Qt 5.2 or greater")
+}
+
+TEMPLATE = app
+QT = core
+CONFIG += console warn_on c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x051000
+
+# Allow in-tree builds
+!win32 {
+	MOC_DIR = build
+	OBJECTS_DIR = build
+	RCC_DIR = build
+}
+
+TARGET = bench_generator
+
+INCLUDEPATH += $$PWD/../src
+DEPENDPATH += $$PWD/../src
+
+# Specify program sources
+HEADERS = ../src/arena.h \
+	../src/bit_matrix.h \
+	../src/dancing_links.h \
+	../src/generator.h \
+	../src/polyomino.h \
+	../src/tile.h
+
+SOURCES = bench_generator.cpp \
+	../src/bit_matrix.cpp \
+	../src/dancing_links.cpp \
+	../src/generator.cpp \
+	../src/tile.cpp
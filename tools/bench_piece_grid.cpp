@@ -0,0 +1,285 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2026 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "piece_grid.h"
+#include "tile.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSize>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Space that board keeps around pieces when checking for collisions
+	const int margin = 16;
+
+	// Size of the selection rectangle dragged across the board
+	const QSize selection_size(600, 400);
+
+	// Parses comma separated list of piece counts, or returns an empty list on error
+	QList<int> parseCounts(const QString& text)
+	{
+		QList<int> counts;
+		for (const QString& item : text.split(',')) {
+			bool ok = false;
+			const int count = item.trimmed().toInt(&ok);
+			if (!ok || (count < 1)) {
+				return QList<int>();
+			}
+			counts.append(count);
+		}
+		return counts;
+	}
+
+	// Lays out bounding rectangles of tetrominoes in jittered rows that form a square;
+	// pieces are about a margin apart, so that some of them are close enough to collide
+	QVector<QRect> layoutPieces(int count, std::mt19937& random)
+	{
+		static const QSize sizes[] = {
+			QSize(4, 1), QSize(1, 4), QSize(3, 2), QSize(2, 3), QSize(2, 2)
+		};
+		std::uniform_int_distribution<int> size_dis(0, 4);
+		std::uniform_int_distribution<int> jitter_dis(0, margin);
+
+		const int row_width = std::sqrt(double(count)) * (Tile::size * 3 + margin);
+
+		QVector<QRect> rects;
+		rects.reserve(count);
+		int x = 0;
+		int y = 0;
+		int row_height = 0;
+		for (int i = 0; i < count; ++i) {
+			const QSize size = sizes[size_dis(random)] * Tile::size;
+			if (x + size.width() > row_width) {
+				x = 0;
+				y += row_height + margin;
+				row_height = 0;
+			}
+			rects.append(QRect(QPoint(x + jitter_dis(random), y + jitter_dis(random)), size));
+			x += size.width() + margin;
+			row_height = std::max(row_height, size.height());
+		}
+		return rects;
+	}
+
+	// Fakes a piece for the grid, which only compares and stores the pointers
+	Piece* fakePiece(const QVector<char>& storage, int index)
+	{
+		return reinterpret_cast<Piece*>(const_cast<char*>(storage.constData() + index));
+	}
+
+	// Finds index of a fake piece
+	int pieceIndex(const QVector<char>& storage, Piece* piece)
+	{
+		return reinterpret_cast<const char*>(piece) - storage.constData();
+	}
+
+	// Prints one query as a CSV row; times are in microseconds
+	void printRow(QTextStream& out, int pieces, const char* query, int queries, quint64 grid_matches, qint64 grid_time, quint64 linear_matches, qint64 linear_time)
+	{
+		out << pieces << ',' << query << ',' << queries << ',' << grid_matches << ','
+			<< int(grid_matches == linear_matches) << ','
+			<< (grid_time / 1000) << ',' << (linear_time / 1000) << '\n';
+		out.flush();
+	}
+
+	// Times queries of the grid against scanning every piece, the way the board used to
+	void benchPieces(int count, int queries, quint32 seed, QTextStream& out)
+	{
+		std::mt19937 random(seed);
+		QVector<QRect> rects = layoutPieces(count, random);
+		QRect bounds;
+		for (const QRect& rect : rects) {
+			bounds |= rect;
+		}
+		const QVector<char> storage(count);
+		QElapsedTimer timer;
+		PieceGrid grid;
+
+		// Add every piece, as when starting or loading a game
+		timer.start();
+		for (int i = 0; i < count; ++i) {
+			grid.insert(fakePiece(storage, i), rects.at(i));
+		}
+		qint64 grid_time = timer.nsecsElapsed();
+		timer.restart();
+		QVector<QRect> linear;
+		for (int i = 0; i < count; ++i) {
+			linear.append(rects.at(i));
+		}
+		qint64 linear_time = timer.nsecsElapsed();
+		printRow(out, count, "insert", count, count, grid_time, linear.count(), linear_time);
+
+		// Nudge every piece a few pixels, as when pieces are pushed apart
+		std::uniform_int_distribution<int> nudge_dis(-margin / 2, margin / 2);
+		for (QRect& rect : rects) {
+			rect.translate(nudge_dis(random), nudge_dis(random));
+		}
+		timer.restart();
+		for (int i = 0; i < count; ++i) {
+			grid.insert(fakePiece(storage, i), rects.at(i));
+		}
+		grid_time = timer.nsecsElapsed();
+		timer.restart();
+		for (int i = 0; i < count; ++i) {
+			linear[i] = rects.at(i);
+		}
+		linear_time = timer.nsecsElapsed();
+		printRow(out, count, "move", count, count, grid_time, linear.count(), linear_time);
+
+		// Find piece under cursor at random points
+		std::uniform_int_distribution<int> x_dis(bounds.left(), bounds.right());
+		std::uniform_int_distribution<int> y_dis(bounds.top(), bounds.bottom());
+		QVector<QPoint> points;
+		for (int i = 0; i < queries; ++i) {
+			points.append(QPoint(x_dis(random), y_dis(random)));
+		}
+		quint64 grid_matches = 0;
+		timer.restart();
+		for (const QPoint& pos : points) {
+			for (Piece* piece : grid.find(QRect(pos, QSize(1, 1)))) {
+				if (rects.at(pieceIndex(storage, piece)).contains(pos)) {
+					++grid_matches;
+					break;
+				}
+			}
+		}
+		grid_time = timer.nsecsElapsed();
+		quint64 linear_matches = 0;
+		timer.restart();
+		for (const QPoint& pos : points) {
+			for (const QRect& rect : linear) {
+				if (rect.contains(pos)) {
+					++linear_matches;
+					break;
+				}
+			}
+		}
+		linear_time = timer.nsecsElapsed();
+		printRow(out, count, "hit", queries, grid_matches, grid_time, linear_matches, linear_time);
+
+		// Find pieces within margin of random pieces, as when checking for collisions
+		std::uniform_int_distribution<int> piece_dis(0, count - 1);
+		QVector<int> pieces;
+		for (int i = 0; i < queries; ++i) {
+			pieces.append(piece_dis(random));
+		}
+		grid_matches = 0;
+		timer.restart();
+		for (int index : pieces) {
+			const QRect rect = rects.at(index).adjusted(-margin, -margin, margin, margin);
+			for (Piece* piece : grid.find(rect)) {
+				const int other = pieceIndex(storage, piece);
+				if ((other != index) && rect.intersects(rects.at(other))) {
+					++grid_matches;
+				}
+			}
+		}
+		grid_time = timer.nsecsElapsed();
+		linear_matches = 0;
+		timer.restart();
+		for (int index : pieces) {
+			const QRect rect = linear.at(index).adjusted(-margin, -margin, margin, margin);
+			for (int other = 0; other < count; ++other) {
+				if ((other != index) && rect.intersects(linear.at(other))) {
+					++linear_matches;
+				}
+			}
+		}
+		linear_time = timer.nsecsElapsed();
+		printRow(out, count, "collide", queries, grid_matches, grid_time, linear_matches, linear_time);
+
+		// Find pieces inside selection rectangles at random points
+		QVector<QRect> selections;
+		for (const QPoint& pos : points) {
+			selections.append(QRect(pos, selection_size));
+		}
+		grid_matches = 0;
+		timer.restart();
+		for (const QRect& selection : selections) {
+			for (Piece* piece : grid.find(selection)) {
+				if (selection.intersects(rects.at(pieceIndex(storage, piece)))) {
+					++grid_matches;
+				}
+			}
+		}
+		grid_time = timer.nsecsElapsed();
+		linear_matches = 0;
+		timer.restart();
+		for (const QRect& selection : selections) {
+			for (const QRect& rect : linear) {
+				if (selection.intersects(rect)) {
+					++linear_matches;
+				}
+			}
+		}
+		linear_time = timer.nsecsElapsed();
+		printRow(out, count, "select", queries, grid_matches, grid_time, linear_matches, linear_time);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	app.setApplicationName("bench_piece_grid");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Times queries of the piece grid against scanning every piece, and prints them as CSV.\n"
+		"Each piece count runs insert, move, hit, collide, and select queries.");
+	parser.addHelpOption();
+	parser.addOption(QCommandLineOption("pieces", "Amounts of pieces to lay out.", "list", "1000,10000,50000"));
+	parser.addOption(QCommandLineOption("queries", "Amount of hit, collide, and select queries for each piece count.", "count", "1000"));
+	parser.addOption(QCommandLineOption("seed", "Seed of the piece layouts and queries.", "seed", "1"));
+	parser.process(app);
+
+	QTextStream err(stderr);
+	const QList<int> counts = parseCounts(parser.value("pieces"));
+	if (counts.isEmpty()) {
+		err << "Piece counts must be a list of positive numbers.\n";
+		return 1;
+	}
+	bool queries_ok = false;
+	bool seed_ok = false;
+	const int queries = parser.value("queries").toInt(&queries_ok);
+	const quint32 seed = parser.value("seed").toUInt(&seed_ok);
+	if (!queries_ok || !seed_ok || (queries < 1)) {
+		err << "Queries and seed must be positive numbers.\n";
+		return 1;
+	}
+
+	// Print one row for each query; matches are counted with exact rectangle tests
+	QTextStream out(stdout);
+	out << "pieces,query,queries,matches,valid,grid_us,linear_us\n";
+	for (int count : counts) {
+		benchPieces(count, queries, seed, out);
+	}
+
+	return 0;
+}
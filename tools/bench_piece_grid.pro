@@ -0,0 +1,38 @@
+# Benchmark of the piece grid; prints times of board queries as CSV
+#
+# Build with 'qmake tools/bench_piece_grid.pro && make', and then run
+# './bench_piece_grid --help' to see which piece counts it sweeps.
+
+lessThan(QT_MAJOR_VERSION, 5) {
+	error("Tetzle requires Qt 5.2 or greater")
+}
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 2) {
+	error("Tetzle requires Qt 5.2 or greater")
+}
+
+TEMPLATE = app
+QT = core
+CONFIG += console warn_on c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x051000
+
+# Allow in-tree builds
+!win32 {
+	MOC_DIR = build
+	OBJECTS_DIR = build
+	RCC_DIR = build
+}
+
+TARGET = bench_piece_grid
+
+INCLUDEPATH += $$PWD/../src
+DEPENDPATH += $$PWD/../src
+
+# Specify program sources
+HEADERS = ../src/piece_grid.h \
+	../src/tile.h
+
+SOURCES = bench_piece_grid.cpp \
+	../src/piece_grid.cpp